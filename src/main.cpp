@@ -1,10 +1,157 @@
 // main.cpp
 #include <scrapers/include/PropertyManager.hpp>
+#include <scrapers/include/blobStore.hpp>
+#include <scrapers/include/changeEvents.hpp>
+#include <scrapers/include/deltaCodec.hpp>
+#include <scrapers/include/gumboArena.hpp>
+#include <scrapers/include/segmentLog.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
+#include <scrapers/include/tagScanner.hpp>
+#include <scrapers/include/textScan.hpp>
+#include <scrapers/meklarin/meklarinParser.hpp>
+#include <string>
+#include <webapi/replayServer.hpp>
 #include <webapi/webapi.hpp>
 
 int main(int argc, char* argv[]) {
   if (argc > 1 && std::string(argv[1]) == "--scrape") {
-    HT::PropertyManager::runPropertyParsers(false);
+    bool downloadNewHtml = false;
+    bool reindex = false;
+    HT::FetchOptions fetchOptions;
+    for (int i = 2; i < argc; ++i) {
+      std::string flag = argv[i];
+      if (flag == "--download")
+        downloadNewHtml = true;
+      else if (flag == "--reindex")
+        reindex = true;
+      else if (flag == "--gumbo-arena")
+        HT::setGumboArena(true);
+      else if (flag == "--tag-scanner")
+        HT::setTagScanner(true);
+      else if (flag == "--max-in-flight" && i + 1 < argc)
+        fetchOptions.maxInFlight = std::stoi(argv[++i]);
+      else if (flag == "--max-per-host" && i + 1 < argc)
+        fetchOptions.maxInFlightPerHost = std::stoi(argv[++i]);
+      else if (flag == "--deadline-seconds" && i + 1 < argc)
+        fetchOptions.runDeadlineMs = std::stol(argv[++i]) * 1000;
+      else if (flag == "--replay" && i + 1 < argc)
+        fetchOptions.replayEndpoint = argv[++i];
+    }
+    HT::PropertyManager::runPropertyParsers(downloadNewHtml, fetchOptions,
+                                           reindex);
+    return 0;
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--replay-server") {
+    HT::ReplayOptions replayOptions;
+    for (int i = 2; i < argc; ++i) {
+      std::string flag = argv[i];
+      if (flag == "--port" && i + 1 < argc)
+        replayOptions.port = std::stoi(argv[++i]);
+      else if (flag == "--latency-ms" && i + 1 < argc)
+        replayOptions.latencyMs = std::stoi(argv[++i]);
+      else if (flag == "--bandwidth-kbps" && i + 1 < argc)
+        replayOptions.bandwidthKbps = std::stoi(argv[++i]);
+    }
+    HT::runReplayServer(replayOptions);
+    return 0;
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--migrate-snapshots") {
+    HT::migrateLegacySnapshots("../src/raw_html");
+    return 0;
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--import-segments") {
+    HT::importSnapshotsToSegments("../src/raw_html");
+    return 0;
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--export-segments") {
+    HT::exportSegmentsToSnapshots("../src/raw_html");
+    return 0;
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--events") {
+    HT::ChangeQuery query;
+    for (int i = 2; i < argc; ++i) {
+      std::string flag = argv[i];
+      if (flag == "--id" && i + 1 < argc)
+        query.id = argv[++i];
+      else if (flag == "--kind" && i + 1 < argc)
+        query.kind = argv[++i];
+      else if (flag == "--since" && i + 1 < argc)
+        query.since = argv[++i];
+    }
+    return HT::printChangeEvents(query);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--bench-delta") {
+    int keyframeInterval = 16;
+    for (int i = 2; i < argc; ++i) {
+      std::string flag = argv[i];
+      if (flag == "--keyframe" && i + 1 < argc)
+        keyframeInterval = std::stoi(argv[++i]);
+    }
+    return HT::benchDeltaEncoding("../src/raw_html", keyframeInterval);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--bench-text") {
+    return HT::benchTextScan("../src/raw_html");
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--verify-text") {
+    size_t count = 400000;
+    unsigned seed = 1;
+    for (int i = 2; i < argc; ++i) {
+      std::string flag = argv[i];
+      if (flag == "--count" && i + 1 < argc)
+        count = std::stoul(argv[++i]);
+      else if (flag == "--seed" && i + 1 < argc)
+        seed = static_cast<unsigned>(std::stoul(argv[++i]));
+    }
+    return HT::verifyTextScan(count, seed);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--bench-meklarin") {
+    return HT::MEKLARIN::benchMeklarinParser("../src/raw_html");
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--verify-meklarin") {
+    size_t count = 3000;
+    unsigned seed = 1;
+    for (int i = 2; i < argc; ++i) {
+      std::string flag = argv[i];
+      if (flag == "--count" && i + 1 < argc)
+        count = std::stoul(argv[++i]);
+      else if (flag == "--seed" && i + 1 < argc)
+        seed = static_cast<unsigned>(std::stoul(argv[++i]));
+    }
+    return HT::MEKLARIN::verifyMeklarinReader("../src/raw_html", count, seed);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--bench-gumbo") {
+    return HT::benchGumboArena("../src/raw_html");
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--verify-scanner") {
+    size_t count = 2000;
+    unsigned seed = 1;
+    std::string dumpDir;
+    for (int i = 2; i < argc; ++i) {
+      std::string flag = argv[i];
+      if (flag == "--count" && i + 1 < argc)
+        count = std::stoul(argv[++i]);
+      else if (flag == "--seed" && i + 1 < argc)
+        seed = static_cast<unsigned>(std::stoul(argv[++i]));
+      else if (flag == "--dump" && i + 1 < argc)
+        dumpDir = argv[++i];
+    }
+    return HT::verifyTagScanner("../src/raw_html", count, seed, dumpDir);
+  }
+
+  if (argc > 1 && std::string(argv[1]) == "--rebuild-manifest") {
+    HT::rebuildManifest("../src/raw_html");
     return 0;
   }
 
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
@@ -7,17 +8,23 @@
 #include <scrapers/betri/betriParser.hpp>
 #include <scrapers/betri/betriScraper.hpp>
 #include <scrapers/include/PropertyManager.hpp>
+#include <scrapers/include/changeEvents.hpp>
 #include <scrapers/include/filesystem.hpp>
 #include <scrapers/include/house_model.hpp>
+#include <scrapers/include/httpClient.hpp>
+#include <scrapers/include/ingestCheckpoint.hpp>
+#include <scrapers/include/parseCache.hpp>
 #include <scrapers/include/parser.hpp>
 #include <scrapers/include/regexParser.hpp>
+#include <scrapers/include/textScan.hpp>
 #include <scrapers/include/scraper.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
 #include <scrapers/meklarin/meklarinParser.hpp>
 #include <scrapers/meklarin/meklarinScraper.hpp>
 #include <scrapers/skyn/skynParser.hpp>
 #include <scrapers/skyn/skynScraper.hpp>
-#include <regex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -59,42 +66,27 @@ void normalizeBetriCityAndAddress(Property &prop) {
   std::string address = prop.address;
   std::string city = prop.city;
 
-  for (char &c : address) {
-    if (c == '\r' || c == '\n' || c == '\t') {
-      c = ' ';
-    }
-  }
-  address = std::regex_replace(address, std::regex("\\s+"), " ");
-  address = trim(address);
+  address = trim(collapseWhitespace(address));
   prop.address = address;
 
   // If city is empty, extract "<postnum> <city>" from the end of address.
-  if (city.empty()) {
-    static const std::regex fromAddress(R"(^(.*)\s+(\d{3})\s+(.+)$)");
-    std::smatch m;
-    if (std::regex_match(address, m, fromAddress)) {
-      const std::string street = trim(m[1].str());
-      const std::string postNum = trim(m[2].str());
-      const std::string cityName = trim(m[3].str());
-      prop.address = street.empty() ? address : street;
-      if (prop.postNum.empty()) {
-        prop.postNum = postNum;
-      }
-      prop.city = cityName;
-      return;
+  std::string_view street, postNum, cityName;
+  if (city.empty() && splitPostCode(address, street, postNum, cityName)) {
+    const std::string trimmedStreet = trim(std::string(street));
+    prop.address = trimmedStreet.empty() ? address : trimmedStreet;
+    if (prop.postNum.empty()) {
+      prop.postNum = trim(std::string(postNum));
     }
+    prop.city = trim(std::string(cityName));
+    return;
   }
 
   // If city is "123 Tórshavn", keep only "Tórshavn" and preserve postnum.
-  static const std::regex cityWithPost(R"(^(\d{3})\s+(.+)$)");
-  std::smatch cm;
-  if (std::regex_match(city, cm, cityWithPost)) {
-    const std::string postNum = trim(cm[1].str());
-    const std::string cityName = trim(cm[2].str());
+  if (splitLeadingPostCode(city, postNum, cityName)) {
     if (prop.postNum.empty()) {
-      prop.postNum = postNum;
+      prop.postNum = trim(std::string(postNum));
     }
-    prop.city = cityName;
+    prop.city = trim(std::string(cityName));
   } else {
     prop.city = trim(city);
   }
@@ -227,76 +219,103 @@ bool PropertyManager::isSameProperty(const Property &a, const Property &b) {
   return a.id == b.id;
 }
 
+PropertyMerger::PropertyMerger(std::vector<Property> &properties,
+                               std::vector<ChangeEvent> *events)
+    : properties(properties), events(events) {
+  indexById.reserve(properties.size());
+  for (size_t i = 0; i < properties.size(); ++i) {
+    indexById.emplace(properties[i].id, i); // the first one wins, as before
+  }
+}
+
+void PropertyMerger::merge(std::vector<Property> &&newOnes,
+                           const std::string &source, long long timestamp) {
+  this->source = &source;
+  this->timestamp = timestamp;
+  for (auto &newProp : newOnes) {
+    merge(std::move(newProp));
+  }
+  this->source = nullptr;
+}
+
+void PropertyMerger::record(ChangeKind kind, const std::string &id,
+                            long long oldValue, long long newValue,
+                            std::string oldText, std::string newText) {
+  if (!events) {
+    return;
+  }
+  ChangeEvent &event = events->emplace_back();
+  event.kind = kind;
+  event.timestamp = timestamp;
+  event.source = source ? *source : "";
+  event.id = id;
+  event.oldValue = oldValue;
+  event.newValue = newValue;
+  event.oldText = std::move(oldText);
+  event.newText = std::move(newText);
+}
+
+void PropertyMerger::merge(Property &&newProp) {
+  auto found = indexById.find(newProp.id);
+  if (found == indexById.end()) {
+    // property not found => new property
+    record(ChangeKind::New, newProp.id, 0, newProp.price);
+    indexById.emplace(newProp.id, properties.size());
+    properties.push_back(std::move(newProp));
+    return;
+  }
+
+  Property &ex = properties[found->second];
+  if (ex.type != newProp.type) {
+    ex.type = newProp.type;
+  }
+  // A price of 0 is a card without one (or one the parser missed), not a
+  // change
+  if (newProp.price > 0 && ex.price != newProp.price) {
+    record(newProp.price > ex.price ? ChangeKind::PriceUp
+                                    : ChangeKind::PriceDown,
+           ex.id, ex.price, newProp.price);
+    ex.price = newProp.price;
+  }
+  if (ex.latestOffer < newProp.latestOffer) {
+    record(ChangeKind::OfferChange, ex.id, ex.latestOffer,
+           newProp.latestOffer);
+    // push the old price into the price history
+    ex.previousPrices.push_back(ex.latestOffer);
+    // update the current price
+    ex.latestOffer = newProp.latestOffer;
+  }
+  if (ex.agent != newProp.agent) {
+    record(ChangeKind::AgentChange, ex.id, 0, 0,
+           PropertyManager::propertyAgentToString(ex.agent),
+           PropertyManager::propertyAgentToString(newProp.agent));
+    ex.agent = newProp.agent;
+  }
+  if (ex.img != newProp.img) {
+    ex.img = std::move(newProp.img);
+  }
+  if (ex.city != newProp.city) {
+    record(ChangeKind::CityChange, ex.id, 0, 0, ex.city, newProp.city);
+    ex.city = std::move(newProp.city);
+  }
+  if (newProp.buildingSize > 0 && ex.buildingSize != newProp.buildingSize) {
+    ex.buildingSize = newProp.buildingSize;
+  }
+  if (newProp.landSize > 0 && ex.landSize != newProp.landSize) {
+    ex.landSize = newProp.landSize;
+  }
+  // you can compare other fields (e.g., floors, rooms) similarly
+}
+
 // Merges new properties into existing, tracking price changes
 void PropertyManager::mergeProperties(std::vector<Property> &existing,
                                       const std::vector<Property> &newOnes) {
-  for (const auto &newProp : newOnes) {
-    // 1) Find match in existing
-    auto it =
-        std::find_if(existing.begin(), existing.end(), [&](const Property &ex) {
-          return isSameProperty(ex, newProp);
-        });
-
-    if (it == existing.end()) {
-      // property not found => new property
-      std::cout << "Adding new property: " << newProp.address << "\n";
-      existing.push_back(newProp);
-    } else {
-      // property found => check if price changed
-      if (it->type != newProp.type) {
-      //  std::cout << "Type changed for: " << it->id << " from "
-      //            << propertyTypeToString(it->type) << " to "
-      //            << propertyTypeToString(newProp.type) << "\n";
-        // update type
-        it->type = newProp.type;
-      }
-      if (it->price < newProp.price) {
-        std::cout << "Price changed for: " << it->address << " from "
-                  << it->price << " to " << newProp.price << "\n";
+  PropertyMerger(existing).merge(std::vector<Property>(newOnes));
+}
 
-        // update the current price
-        it->price = newProp.price;
-      }
-      if (it->latestOffer < newProp.latestOffer) {
-        std::cout << "Price changed for: " << it->address << " from "
-                  << it->latestOffer << " to " << newProp.latestOffer << "\n";
-
-        // push the old price into the price history
-        it->previousPrices.push_back(it->latestOffer);
-        // update the current price
-        it->latestOffer = newProp.latestOffer;
-      }
-      // property found => check if agent changed
-      if (it->agent != newProp.agent) {
-        std::cout << "Agent changed for: " << it->id << " from "
-                  << propertyAgentToString(it->agent) << " to "
-                  << propertyAgentToString(newProp.agent) << "\n";
-        // update Agent
-        it->agent = newProp.agent;
-      }
-      // property found => check if img changed
-      if (it->img != newProp.img) {
-      //  std::cout << "img changed for: " << it->id << " from " << it->img
-      //            << " to " << newProp.img << "\n";
-        // update img
-        it->img = newProp.img;
-      }
-      // property found => check if agent changed
-      if (it->city != newProp.city) {
-        std::cout << "City changed for: " << it->id << " from " << it->city
-                  << " to " << newProp.city << "\n";
-        // update city
-        it->city = newProp.city;
-      }
-      if (newProp.buildingSize > 0 && it->buildingSize != newProp.buildingSize) {
-        it->buildingSize = newProp.buildingSize;
-      }
-      if (newProp.landSize > 0 && it->landSize != newProp.landSize) {
-        it->landSize = newProp.landSize;
-      }
-      // you can compare other fields (e.g., floors, rooms) similarly
-    }
-  }
+void PropertyManager::mergeProperties(std::vector<Property> &existing,
+                                      std::vector<Property> &&newOnes) {
+  PropertyMerger(existing).merge(std::move(newOnes));
 }
 
 std::vector<Property>
@@ -329,126 +348,342 @@ mapRawPropertiesTilProperties(std::vector<RawProperty> newProperties) {
   return properties;
 }
 
+namespace {
+
+// One distinct snapshot body and what its agent parser found in it
+struct SnapshotParse {
+  const SnapshotRecord *record = nullptr; // first entry with this body
+  std::string cacheKey;
+  bool loaded = false;
+  bool cached = false; // taken from the parse cache
+  std::vector<RawProperty> rawProperties;
+  std::vector<Property> properties;
+};
+
+// Parse cache key of a body: what it is, and which parser (at which
+// version) reads it. "" when no parser handles the url.
+std::string parseCacheKey(const SnapshotRecord &record) {
+  std::string parser;
+  if (record.url.find("betriheim") != std::string::npos)
+    parser = "betri|" + std::to_string(HT::BETRI::kParserVersion);
+  if (record.url.find("meklarin") != std::string::npos)
+    parser = "meklarin|" + std::to_string(HT::MEKLARIN::kParserVersion);
+  if (record.url.find("skyn") != std::string::npos)
+    parser = "skyn|" + std::to_string(HT::SKYN::kParserVersion);
+  if (parser.empty()) {
+    return "";
+  }
+  return record.hash + "|" + record.type + "|" + parser;
+}
+
+} // namespace
+
+std::vector<RawProperty> parseSnapshotHtml(const SnapshotRecord &record,
+                                           const std::string &rawHtml) {
+  PropertyType propType = PropertyManager::stringToPropertyType(record.type);
+  const std::string &website = record.url;
+
+  std::vector<RawProperty> newRawProperties;
+  // Parse
+  size_t betriFound = website.find("betriheim");
+  if (betriFound != std::string::npos)
+    newRawProperties = HT::BETRI::parseHtmlWithGumboBetri(rawHtml, propType);
+
+  size_t meklarinFound = website.find("meklarin");
+  if (meklarinFound != std::string::npos)
+    newRawProperties = HT::MEKLARIN::parseWithGumboMeklarin(rawHtml);
+
+  size_t skynFound = website.find("skyn");
+  if (skynFound != std::string::npos)
+    newRawProperties = HT::SKYN::parseWithGumboSkyn(rawHtml, propType);
+
+  return newRawProperties;
+}
+
+std::string describeRawProperties(const std::vector<RawProperty> &properties) {
+  std::string out;
+  for (const auto &p : properties) {
+    for (const auto *field :
+         {&p.id, &p.website, &p.address, &p.houseNum, &p.city, &p.postNum,
+          &p.price, &p.latestOffer, &p.validDate, &p.date, &p.buildingSize,
+          &p.landSize, &p.room, &p.floor, &p.img, &p.type, &p.agent}) {
+      out += *field;
+      out += '|';
+    }
+    out += '\n';
+  }
+  return out;
+}
+
+namespace {
+
+// Loads and parses the bodies the cache did not have on all cores. Every
+// result goes to its own slot, so nothing is shared between the workers
+// but the next index.
+void parseSnapshots(const std::filesystem::path &rawHtmlDir,
+                    std::vector<SnapshotParse> &parses) {
+  std::atomic<size_t> next{0};
+  auto work = [&]() {
+    std::string rawHtml; // one buffer per worker, reused for every body
+    for (size_t i = next++; i < parses.size(); i = next++) {
+      SnapshotParse &parse = parses[i];
+      if (parse.loaded) {
+        continue;
+      }
+      if (!loadSnapshotPage(rawHtmlDir, *parse.record, rawHtml)) {
+        std::cerr << "No HTML found in " << parse.record->file << "\n";
+        continue;
+      }
+      try {
+        parse.rawProperties = parseSnapshotHtml(*parse.record, rawHtml);
+        parse.loaded = true;
+      } catch (const std::exception &e) {
+        std::cerr << "Failed to parse " << parse.record->file << ": "
+                  << e.what() << "\n";
+      }
+    }
+  };
+
+  const size_t workerCount =
+      std::min<size_t>(parses.size(), std::thread::hardware_concurrency());
+  std::vector<std::thread> workers;
+  for (size_t w = 1; w < workerCount; ++w) {
+    workers.emplace_back(work);
+  }
+  work(); // the calling thread takes a share too
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+} // namespace
+
 void PropertyManager::traverseAllHtmlAndMergeProperties(
     std::vector<Property> &allProperties,
     std::vector<std::filesystem::path> htmlFiles) {
-  std::unordered_map<std::string, long long> latestTimestampByUrl;
-  std::unordered_map<std::string, std::filesystem::path> latestPathByUrl;
-  std::unordered_map<std::string, long long> firstSeenTimestampById;
-  std::unordered_map<std::string, long long> lastSeenTimestampById;
-
-  for (const auto &path : htmlFiles) {
-    std::ifstream ifs(path);
-    if (!ifs.is_open()) {
-      continue;
+  // Everything but the page bodies comes from the manifest, so entry files
+  // are only opened when a legacy entry embeds its page
+  const std::filesystem::path rawHtmlDir =
+      htmlFiles.empty() ? std::filesystem::path()
+                        : htmlFiles.front().parent_path();
+  IngestCheckpoint checkpoint;
+  ingestNewSnapshots(allProperties, snapshotRecordsFor(rawHtmlDir, htmlFiles),
+                     rawHtmlDir, checkpoint);
+}
+
+void PropertyManager::ingestNewSnapshots(
+    std::vector<Property> &allProperties,
+    const std::vector<SnapshotRecord> &records,
+    const std::filesystem::path &rawHtmlDir, IngestCheckpoint &checkpoint,
+    std::vector<ChangeEvent> *events) {
+
+  // Entry names sort chronologically, so what is new is what sorts after
+  // the checkpoint. If the entries up to it are no longer the ones that
+  // were ingested (restored from elsewhere, or deleted), start over.
+  auto firstNew = std::find_if(
+      records.begin(), records.end(), [&](const SnapshotRecord &record) {
+        return record.file > checkpoint.lastFile;
+      });
+  if (static_cast<size_t>(firstNew - records.begin()) !=
+      checkpoint.ingestedCount) {
+    std::cout << "Snapshots before the ingest checkpoint changed; "
+                 "ingesting everything\n";
+    checkpoint.clear();
+    firstNew = records.begin();
+  }
+  const std::vector<SnapshotRecord> newRecords(firstNew, records.end());
+
+  for (const auto &record : newRecords) {
+    IngestCheckpoint::UrlState &urlState = checkpoint.byUrl[record.url];
+    urlState.lastConfirmed =
+        std::max(urlState.lastConfirmed, record.timestamp);
+    if (record.unchanged) {
+      continue; // a marker has no listings of its own
     }
-    nlohmann::json j;
-    try {
-      ifs >> j;
-    } catch (...) {
-      continue;
+
+    if (urlState.latestFile.empty() ||
+        record.timestamp >= urlState.latestTimestamp) {
+      urlState.latestTimestamp = record.timestamp;
+      urlState.latestFile = record.file;
+      urlState.ids.clear(); // filled in once it is parsed
     }
-    const std::string website = j.value("url", "");
-    const long long timestamp = j.value("timestamp", 0LL);
-    if (website.empty()) {
+  }
+
+  // Each distinct body is parsed once, on a worker thread; the merge below
+  // then walks the entries in order, exactly as a serial run would
+  std::vector<SnapshotParse> parses;
+  std::unordered_map<std::string, size_t> parseIndexByKey;
+  std::vector<size_t> parseIndexByRecord(newRecords.size());
+  for (size_t i = 0; i < newRecords.size(); ++i) {
+    const SnapshotRecord &record = newRecords[i];
+    if (record.unchanged) {
       continue;
     }
-
-    auto it = latestTimestampByUrl.find(website);
-    if (it == latestTimestampByUrl.end() || timestamp >= it->second) {
-      latestTimestampByUrl[website] = timestamp;
-      latestPathByUrl[website] = path;
+    const std::string parseKey =
+        record.hash + "|" + record.type + "|" + record.url;
+    auto [it, added] = parseIndexByKey.emplace(parseKey, parses.size());
+    if (added) {
+      parses.push_back({&record, parseCacheKey(record), false, false, {}, {}});
     }
+    parseIndexByRecord[i] = it->second;
   }
 
-  std::unordered_set<std::string> activePropertyIds;
-
-  for (const auto &path : htmlFiles) {
-    std::ifstream ifs(path);
-    if (!ifs.is_open()) {
-      std::cerr << "Failed to open " << path << "\n";
+  // Gumbo only runs for bodies the cache has no result for at the current
+  // parser versions
+  ParseCache parseCache;
+  parseCache.load();
+  for (auto &parse : parses) {
+    if (!parse.cacheKey.empty() &&
+        parseCache.find(parse.cacheKey, parse.rawProperties)) {
+      parse.loaded = true;
+      parse.cached = true;
+    }
+  }
+  parseSnapshots(rawHtmlDir, parses);
+  for (auto &parse : parses) {
+    if (!parse.loaded) {
       continue;
     }
+    if (!parse.cached && !parse.cacheKey.empty()) {
+      parseCache.add(parse.cacheKey, parse.rawProperties);
+    }
+    parse.properties = mapRawPropertiesTilProperties(
+        std::move(parse.rawProperties));
+  }
+  if (!parses.empty()) {
+    std::cout << "Parsed " << parses.size() - parseCache.hits()
+              << " pages, " << parseCache.hits()
+              << " came from the parse cache\n";
+    // After a full ingest the cache keeps only what is still in use
+    parseCache.save(firstNew == records.begin());
+  }
 
-    nlohmann::json j;
-    ifs >> j;
-    ifs.close();
-
-    // If your JSON structure is: { "url": "...", "timestamp": ..., "html":
-    // "..." }
-    PropertyType propType =
-        PropertyManager::stringToPropertyType(j.value("type", ""));
-
-    std::string website = j.value("url", "");
-    const long long timestamp = j.value("timestamp", 0LL);
-    // if (website != url || website.empty())
-    //   continue;
+  // Entries sharing a body share its parse; the last of them moves it out
+  std::vector<size_t> lastRecordByParse(parses.size());
+  for (size_t i = 0; i < newRecords.size(); ++i) {
+    if (!newRecords[i].unchanged) {
+      lastRecordByParse[parseIndexByRecord[i]] = i;
+    }
+  }
 
-    std::string rawHtml = j.value("html", "");
-    if (rawHtml.empty()) {
-      std::cerr << "No HTML found in " << path << "\n";
+  // Starting over replays every snapshot into properties that already hold
+  // what it leads to, so what the merge sees change is not history. The log
+  // only gets a New event for each property, where it was first seen.
+  const bool replay = firstNew == records.begin() && !allProperties.empty();
+  std::vector<ChangeEvent> *history = replay ? nullptr : events;
+  std::unordered_map<std::string, ChangeEvent> firstSightings;
+
+  PropertyMerger merger(allProperties, history);
+  for (size_t i = 0; i < newRecords.size(); ++i) {
+    const SnapshotRecord &record = newRecords[i];
+    if (record.unchanged) {
+      continue;
+    }
+    SnapshotParse &parse = parses[parseIndexByRecord[i]];
+    if (!parse.loaded) {
       continue;
     }
 
-    std::vector<RawProperty> newRawProperties;
-    // Parse
-    size_t betriFound = website.find("betriheim");
-    if (betriFound != std::string::npos)
-      newRawProperties = HT::BETRI::parseHtmlWithGumboBetri(rawHtml, propType);
-
-    size_t meklarinFound = website.find("meklarin");
-    if (meklarinFound != std::string::npos)
-      newRawProperties = HT::MEKLARIN::parseWithGumboMeklarin(rawHtml);
-
-    size_t skynFound = website.find("skyn");
-    if (skynFound != std::string::npos)
-      newRawProperties = HT::SKYN::parseWithGumboSkyn(rawHtml, propType);
-
-    std::vector<Property> newProperties =
-        mapRawPropertiesTilProperties(newRawProperties);
+    const std::string &website = record.url;
+    const long long timestamp = record.timestamp;
+    const std::vector<Property> &newProperties = parse.properties;
 
     for (const auto &prop : newProperties) {
-      auto seenIt = firstSeenTimestampById.find(prop.id);
-      if (seenIt == firstSeenTimestampById.end() || timestamp < seenIt->second) {
-        firstSeenTimestampById[prop.id] = timestamp;
+      auto seenIt = checkpoint.firstSeenById.find(prop.id);
+      if (seenIt == checkpoint.firstSeenById.end() ||
+          timestamp < seenIt->second) {
+        checkpoint.firstSeenById[prop.id] = timestamp;
+        if (replay && events) {
+          firstSightings[prop.id] = {ChangeKind::New, timestamp, record.file,
+                                     prop.id, 0, prop.price, "", ""};
+        }
       }
-      auto lastSeenIt = lastSeenTimestampById.find(prop.id);
-      if (lastSeenIt == lastSeenTimestampById.end() ||
+      auto lastSeenIt = checkpoint.lastSeenById.find(prop.id);
+      if (lastSeenIt == checkpoint.lastSeenById.end() ||
           timestamp > lastSeenIt->second) {
-        lastSeenTimestampById[prop.id] = timestamp;
+        checkpoint.lastSeenById[prop.id] = timestamp;
       }
     }
 
-    auto latestIt = latestPathByUrl.find(website);
-    if (latestIt != latestPathByUrl.end() && path == latestIt->second) {
+    IngestCheckpoint::UrlState &urlState = checkpoint.byUrl[website];
+    if (record.file == urlState.latestFile) {
       for (const auto &prop : newProperties) {
-        activePropertyIds.insert(prop.id);
+        urlState.ids.push_back(prop.id);
       }
     }
 
     // Merge
-    PropertyManager::mergeProperties(allProperties, newProperties);
+    if (lastRecordByParse[parseIndexByRecord[i]] == i) {
+      merger.merge(std::move(parse.properties), record.file, timestamp);
+    } else {
+      merger.merge(std::vector<Property>(newProperties), record.file,
+                   timestamp);
+    }
 
-    //std::cout << "Processed file: " << path.filename().string() << " => found "
+    //std::cout << "Processed file: " << record.file << " => found "
     //          << newProperties.size() << " properties.\n";
   }
 
+  if (!records.empty()) {
+    checkpoint.lastFile = records.back().file;
+    checkpoint.ingestedCount = records.size();
+  }
+  if (!newRecords.empty()) {
+    std::cout << "Ingested " << newRecords.size() << " new snapshots\n";
+  }
+  if (!firstSightings.empty()) {
+    std::vector<ChangeEvent> seeded;
+    seeded.reserve(firstSightings.size());
+    for (auto &[id, event] : firstSightings) {
+      seeded.push_back(std::move(event));
+    }
+    std::sort(seeded.begin(), seeded.end(),
+              [](const ChangeEvent &a, const ChangeEvent &b) {
+                return a.source != b.source ? a.source < b.source
+                                            : a.id < b.id;
+              });
+    events->insert(events->end(), std::make_move_iterator(seeded.begin()),
+                   std::make_move_iterator(seeded.end()));
+  }
+
+  // The newest snapshot of every url says what is still listed, and a
+  // later 304 marker proves those listings were still up then
+  std::unordered_set<std::string> activePropertyIds;
+  for (const auto &[url, urlState] : checkpoint.byUrl) {
+    for (const auto &id : urlState.ids) {
+      activePropertyIds.insert(id);
+      long long &lastSeen = checkpoint.lastSeenById[id];
+      lastSeen = std::max(lastSeen, urlState.lastConfirmed);
+    }
+  }
+
   for (auto &prop : allProperties) {
     normalizeBetriCityAndAddress(prop);
     if (prop.addedDate.empty()) {
-      auto firstSeenIt = firstSeenTimestampById.find(prop.id);
-      if (firstSeenIt != firstSeenTimestampById.end()) {
+      auto firstSeenIt = checkpoint.firstSeenById.find(prop.id);
+      if (firstSeenIt != checkpoint.firstSeenById.end()) {
         prop.addedDate = formatTimestampAsDate(firstSeenIt->second);
       }
     }
+    auto lastSeenIt = checkpoint.lastSeenById.find(prop.id);
+    const long long lastSeen =
+        lastSeenIt != checkpoint.lastSeenById.end() ? lastSeenIt->second : 0;
+    const bool wasArchived = prop.status == "archived";
     if (activePropertyIds.find(prop.id) != activePropertyIds.end()) {
       prop.status = "active";
       prop.archivedDate.clear();
+      if (wasArchived && history && !records.empty()) {
+        history->push_back({ChangeKind::Relisted, lastSeen,
+                           records.back().file, prop.id, 0, 0, "", ""});
+      }
     } else {
       prop.status = "archived";
-      auto lastSeenIt = lastSeenTimestampById.find(prop.id);
-      if (lastSeenIt != lastSeenTimestampById.end()) {
-        prop.archivedDate = formatTimestampAsDate(lastSeenIt->second);
+      if (lastSeen > 0) {
+        prop.archivedDate = formatTimestampAsDate(lastSeen);
+      }
+      if (!wasArchived && history && !records.empty()) {
+        history->push_back({ChangeKind::Archived, lastSeen,
+                           records.back().file, prop.id, 0, 0, "", ""});
       }
     }
   }
@@ -472,27 +707,66 @@ std::string PropertyManager::cleanId(const std::string &raw) {
 }
 
 int PropertyManager::runPropertyParsers(bool downloadNewHtml) {
+  return runPropertyParsers(downloadNewHtml, FetchOptions{});
+}
+
+int PropertyManager::runPropertyParsers(bool downloadNewHtml,
+                                        const FetchOptions &fetchOptions,
+                                        bool reindex) {
 
-  HT::betriRun(downloadNewHtml);
-  HT::meklarinRun(downloadNewHtml);
-  HT::skynRun(downloadNewHtml);
+  if (downloadNewHtml) {
+    // All agents go through one engine so the whole scrape runs concurrently
+    std::vector<FetchJob> jobs = HT::meklarinJobs();
+    for (auto &job : HT::skynJobs())
+      jobs.push_back(std::move(job));
+    std::vector<PagedJob> pagedJobs = HT::betriJobs();
+
+    int saved = HT::fetchAndSaveAll(jobs, fetchOptions, pagedJobs);
+    std::cout << "Saved " << saved << " of " << jobs.size() + pagedJobs.size()
+              << " snapshots\n";
+  }
 
   std::vector<Property> allProperties = HT::getAllPropertiesFromJson();
 
   std::string rawHtmlDir = "../src/raw_html";
 
-  std::vector<std::filesystem::path> htmlFiles =
-      HT::gatherJsonFiles(rawHtmlDir);
+  std::vector<SnapshotRecord> records =
+      HT::archivedSnapshotRecords(rawHtmlDir);
 
-  if (htmlFiles.empty()) {
-    std::cerr << "No JSON files found in " << rawHtmlDir << "\n";
+  if (records.empty()) {
+    std::cerr << "No snapshots found in " << rawHtmlDir << "\n";
     return 0;
   }
 
-  PropertyManager::traverseAllHtmlAndMergeProperties(allProperties, htmlFiles);
-
-  HT::writeToPropertiesJsonFile(allProperties);
-  HT::checkAndDownloadImages(allProperties);
+  // Without properties.json the facts in the checkpoint have nothing to
+  // apply to, so everything is ingested again
+  IngestCheckpoint checkpoint;
+  if (!reindex && !allProperties.empty()) {
+    checkpoint.load();
+  }
+  std::vector<ChangeEvent> events;
+  PropertyManager::ingestNewSnapshots(allProperties, records, rawHtmlDir,
+                                      checkpoint, &events);
+
+  if (HT::writeToPropertiesJsonFile(allProperties) == 0) {
+    checkpoint.save();
+    const int logged = appendChangeEvents(events);
+    if (logged > 0) {
+      std::cout << "Logged " << logged << " change events\n";
+    }
+  }
+  HT::checkAndDownloadImages(allProperties, fetchOptions);
+
+  TransferStats transferStats = HttpClient::instance().stats();
+  if (transferStats.transfers > 0) {
+    std::cout << "Connections: " << transferStats.transfers << " transfers ("
+              << transferStats.http2Transfers << " over HTTP/2), "
+              << transferStats.reusedConnections << " on a reused connection, "
+              << transferStats.newConnections << " new connections\n";
+    std::cout << "Bytes: " << transferStats.wireBytes << " on the wire, "
+              << transferStats.decodedBytes << " after decoding\n";
+  }
+  HttpClient::instance().resetStats();
   return 0;
 }
 
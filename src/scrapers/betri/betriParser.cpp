@@ -2,18 +2,27 @@
 #include <gumbo.h>
 #include <iostream>
 #include <nlohmann/json.hpp>
-#include <regex>
-#include <scrapers/betri/betriModel.hpp>
 #include <scrapers/betri/betriParser.hpp>
 #include <scrapers/include/PropertyManager.hpp>
+#include <scrapers/include/cardExtractor.hpp>
+#include <scrapers/include/gumboArena.hpp>
 #include <scrapers/include/house_model.hpp>
 #include <scrapers/include/parser.hpp>
+#include <scrapers/include/tagScanner.hpp>
+#include <scrapers/include/textScan.hpp>
 #include <string>
 namespace HT::BETRI {
 namespace {
 
+// True for the {"html": "..."} API payload that older snapshots stored
+// verbatim; stored pages are plain HTML and skip the JSON parse
+bool isJsonPayload(const std::string &payload) {
+  const auto first = payload.find_first_not_of(" \t\r\n");
+  return first != std::string::npos && payload[first] == '{';
+}
+
 std::string extractBetriHtmlPayload(const std::string &payload) {
-  if (payload.empty()) {
+  if (!isJsonPayload(payload)) {
     return payload;
   }
 
@@ -38,20 +47,14 @@ std::string trim(const std::string &s) {
   return s.substr(first, last - first + 1);
 }
 
-void normalizeAndSplitBetriAddress(BetriProperty &prop) {
+void normalizeAndSplitBetriAddress(RawProperty &prop) {
   std::string addr = prop.address;
   if (addr.empty()) {
     return;
   }
 
   // Flatten line breaks/tabs and collapse repeated whitespace.
-  for (char &c : addr) {
-    if (c == '\r' || c == '\n' || c == '\t') {
-      c = ' ';
-    }
-  }
-  addr = std::regex_replace(addr, std::regex("\\s+"), " ");
-  addr = trim(addr);
+  addr = trim(collapseWhitespace(addr));
   prop.address = addr;
 
   if (!prop.city.empty()) {
@@ -59,200 +62,134 @@ void normalizeAndSplitBetriAddress(BetriProperty &prop) {
   }
 
   // Typical Betri format in one field: "<street> <postnum> <city>"
-  static const std::regex cityAtEnd(R"(^(.*)\s+(\d{3})\s+(.+)$)");
-  std::smatch m;
-  if (std::regex_match(addr, m, cityAtEnd)) {
-    const std::string street = trim(m[1].str());
-    const std::string postNum = trim(m[2].str());
-    const std::string cityName = trim(m[3].str());
-    prop.address = street.empty() ? addr : street;
-    prop.postNum = postNum;
-    prop.city = cityName;
+  std::string_view street, postNum, cityName;
+  if (splitPostCode(addr, street, postNum, cityName)) {
+    const std::string trimmedStreet = trim(std::string(street));
+    prop.address = trimmedStreet.empty() ? addr : trimmedStreet;
+    prop.postNum = trim(std::string(postNum));
+    prop.city = trim(std::string(cityName));
   }
 }
 
-} // namespace
-
-const char *findImgSrcRecursive(GumboNode *node) {
-  if (!node || node->type != GUMBO_NODE_ELEMENT)
-    return nullptr;
+// The fields of a <article class="c-property c-card grid"> block. Each one
+// sits in an element whose whole class attribute names it, e.g.
+// <address class="medium">MyAddress</address>; the image is the first one
+// in <li class="slide" data-slider-id="1">.
+const CardExtractor &betriCard() {
+  static const CardExtractor extractor(CardSpec{
+      {
+          {"price", ClassMatch::Whole, FieldSource::Text, &RawProperty::price},
+          {"latest-offer", ClassMatch::Whole, FieldSource::Text,
+           &RawProperty::latestOffer},
+          {"valid", ClassMatch::Whole, FieldSource::Text,
+           &RawProperty::validDate},
+          {"date", ClassMatch::Whole, FieldSource::Text, &RawProperty::date},
+          {"building-size", ClassMatch::Whole, FieldSource::Text,
+           &RawProperty::buildingSize},
+          {"land-size", ClassMatch::Whole, FieldSource::Text,
+           &RawProperty::landSize},
+          {"rooms", ClassMatch::Whole, FieldSource::Text, &RawProperty::room},
+          {"floors", ClassMatch::Whole, FieldSource::Text,
+           &RawProperty::floor},
+          {"medium", ClassMatch::Whole, FieldSource::Text,
+           &RawProperty::address},
+      },
+      ImageSpec{GUMBO_TAG_LI, "slide", "data-slider-id", "1", nullptr, "",
+                true},
+  });
+  return extractor;
+}
 
-  if (node->v.element.tag == GUMBO_TAG_IMG) {
-    GumboAttribute *src =
-        gumbo_get_attribute(&node->v.element.attributes, "src");
-    return src ? src->value : nullptr;
-  }
-  GumboVector *kids = &node->v.element.children;
-  for (unsigned i = 0; i < kids->length; ++i)
-    if (const char *s =
-            findImgSrcRecursive(static_cast<GumboNode *>(kids->data[i])))
-      return s;
+} // namespace
 
-#if GUMBO_VERSION >= 0x000a03
-  if (node->v.element.template_contents) { // dive into <template>
-    if (const char *s = findImgSrcRecursive(
-            static_cast<GumboNode *>(node->v.element.template_contents)))
-      return s;
-  }
-#endif
-  return nullptr;
+bool isBetriCard(const char *classAttr) {
+  return classAttr && (std::strcmp(classAttr, "c-property c-card grid") == 0 ||
+                       std::strcmp(classAttr, "c-property c-card grid ") == 0);
 }
 
-// Example function: parse an individual “Betri” property from a node that
-// corresponds to the <article class="c-property c-card grid"> block
-void parseBetriProperty(GumboNode *node, BetriProperty *p) {
+// Recursively find <article class="c-property c-card grid"> in the DOM
+void findBetriProperties(GumboNode *node, std::vector<RawProperty> &results,
+                         PropertyType propType) {
   if (!node || node->type != GUMBO_NODE_ELEMENT) {
     return;
   }
 
-  // Check the node’s class attribute
-  const char *classAttr = getClassAttr(node);
-  if (classAttr) {
-    std::string classStr = classAttr;
-
-    // Whenever we see a node whose class is one of these, store its text
-    // (In your HTML snippet, these divs all eventually appear under `<div
-    // class="content">`.)
-    if (classStr == "price") {
-      p->price = getNodeText(node);
-    } else if (classStr == "latest-offer") {
-      p->latestOffer = getNodeText(node);
-    } else if (classStr == "valid") {
-      p->validDate = getNodeText(node);
-    } else if (classStr == "date") {
-      p->date = getNodeText(node);
-    } else if (classStr == "building-size") {
-      p->buildingSize = getNodeText(node);
-    } else if (classStr == "land-size") {
-      p->landSize = getNodeText(node);
-    } else if (classStr == "rooms") {
-      p->room = getNodeText(node);
-    } else if (classStr == "floors") {
-      p->floor = getNodeText(node);
-    } else if (classStr == "medium") {
-      // e->g. <address class="medium">MyAddress</address>
-      p->address = getNodeText(node);
-    }
-  }
-
-  // For the image: inside a <li class="slide"><img src="..."></li>
-  // This might not be a direct child – you may need deeper recursion.
-  // But if it is, do something like below:
-  bool gotImg = !p->img.empty(); // already set elsewhere?
-
-  if (!gotImg && node->v.element.tag == GUMBO_TAG_LI) {
-    const char *liClassAttr =
-        getAttribute(&node->v.element.attributes, "class");
-
-    if (liClassAttr && std::string(liClassAttr) == "slide") {
-      // check data-slider-id="1" on this <li>
-      const char *sliderId =
-          getAttribute(&node->v.element.attributes, "data-slider-id");
-      if (sliderId && strcmp(sliderId, "1") == 0) {
-        // Now scan children to find the first <img>
-        if (const char *src = findImgSrcRecursive(node)) {
-          p->img = src;
-          gotImg = true;
-        }
-      }
-    }
+  if (isBetriCard(getClassAttr(node))) {
+    RawProperty &prop = results.emplace_back();
+    betriCard().extract(node, prop);
+    normalizeAndSplitBetriAddress(prop);
+    prop.website = "Betri";
+    prop.type = PropertyManager::propertyTypeToString(propType);
+    // Keep ID composition stable with old Betri IDs: address + post + city.
+    prop.id = PropertyManager::cleanId(prop.address + prop.postNum + prop.city);
+    prop.agent = PropertyManager::propertyAgentToString(RealEstateAgent::Betri);
   }
 
-  // Recurse on all children
+  // Recurse on children
   GumboVector *children = &node->v.element.children;
   for (unsigned int i = 0; i < children->length; i++) {
-    GumboNode *child = static_cast<GumboNode *>(children->data[i]);
-    parseBetriProperty(child, p);
+    findBetriProperties(static_cast<GumboNode *>(children->data[i]), results,
+                        propType);
   }
 }
 
-// Recursively find <article class="c-property c-card grid"> in the DOM
-void findBetriProperties(GumboNode *node, std::vector<BetriProperty> &results) {
-  if (!node)
-    return;
-
-  if (node->type == GUMBO_NODE_ELEMENT) {
-    // Check if this node is an <article> with class="c-property c-card grid"
-    // if (node->v.element.tag == GUMBO_TAG_ARTICLE || node->v.element.tag ==
-    // GUMBO_TAG_HTML) {
-    const char *classAttr = getAttribute(&node->v.element.attributes, "class");
-    if ((classAttr && std::string(classAttr) == "c-property c-card grid ") ||
-        (classAttr && std::string(classAttr) == "c-property c-card grid")) {
-      // parse this entire block as a Betri property
-      BetriProperty prop;
-      prop.website = "Betri";
-      parseBetriProperty(node, &prop);
-      results.push_back(prop);
-    }
-    //}
+namespace {
 
-    // Recurse on children
-    GumboVector *children = &node->v.element.children;
-    for (unsigned int i = 0; i < children->length; i++) {
-      GumboNode *child = static_cast<GumboNode *>(children->data[i]);
-      findBetriProperties(child, results);
-    }
+// The page itself, or the html an API payload carries; only unwraps (and
+// copies) when the page really is an API payload
+const std::string &pageHtml(const std::string &payload,
+                            std::string &unwrapped) {
+  if (isJsonPayload(payload)) {
+    unwrapped = extractBetriHtmlPayload(payload);
   }
+  return unwrapped.empty() ? payload : unwrapped;
 }
 
-std::vector<RawProperty>
-mapBetriToRawProperty(std::vector<RawProperty> &rawProperties,
-                      std::vector<BetriProperty> &betriProperties,
-                      PropertyType propType) {
-  for (auto &prop : betriProperties) {
-    RawProperty p;
-    normalizeAndSplitBetriAddress(prop);
-    prop.type = PropertyManager::propertyTypeToString(propType);
-    // Keep ID composition stable with old Betri IDs: address + post + city.
-    prop.id = PropertyManager::cleanId(prop.address + prop.postNum + prop.city);
+} // namespace
 
-    p.id = prop.id;
-    p.website = prop.website;
-    p.address = prop.address;
-    p.type = prop.type;
-    p.houseNum = prop.houseNum;
-    p.city = prop.city;
-    p.postNum = prop.postNum;
-    p.price = prop.price;
-    p.previousPrices = prop.previousPrices;
-    p.latestOffer = prop.latestOffer;
-    p.validDate = prop.validDate;
-    p.date = prop.date;
-    p.buildingSize = prop.buildingSize;
-    p.landSize = prop.landSize;
-    p.room = prop.room;
-    p.floor = prop.floor;
-    p.img = prop.img;
-    p.agent = PropertyManager::propertyAgentToString(RealEstateAgent::Betri);
-    rawProperties.push_back(p);
+bool scanBetriPage(const std::string &payload, PropertyType propType,
+                   std::vector<RawProperty> &out) {
+  std::string unwrapped;
+  const std::string &html = pageHtml(payload, unwrapped);
+  const bool scanned = scanElements(html, isBetriCard, [&](GumboNode *card) {
+    findBetriProperties(card, out, propType);
+  });
+  if (!scanned) {
+    out.clear();
+  }
+  return scanned;
+}
+
+std::vector<RawProperty> parseBetriWithGumbo(const std::string &payload,
+                                             PropertyType propType) {
+  std::vector<RawProperty> rawProperties;
+  std::string unwrapped;
+  const std::string &html = pageHtml(payload, unwrapped);
+
+  GumboDocument document(html);
+  if (!document.output()) {
+    std::cerr << "Failed to parse HTML with Gumbo\n";
+    return rawProperties;
   }
+  findBetriProperties(document.root(), rawProperties, propType);
   return rawProperties;
 }
 
-// parse the Html with Gumbo
-std::vector<RawProperty> parseHtmlWithGumboBetri(std::string html,
+// parse the Html with Gumbo, or with the tag scanner first when it is on
+std::vector<RawProperty> parseHtmlWithGumboBetri(const std::string &payload,
                                                  PropertyType propType) {
-  std::vector<BetriProperty> betriProperties;
   std::vector<RawProperty> rawProperties;
-  html = extractBetriHtmlPayload(html);
+  std::string unwrapped;
+  const std::string &html = pageHtml(payload, unwrapped);
 
   if (html.empty()) {
     std::cerr << "Failed to load or download HTML.\n";
     return rawProperties;
   }
 
-  // 2. Parse with Gumbo
-  GumboOutput *output = gumbo_parse(html.c_str());
-  if (!output) {
-    std::cerr << "Failed to parse HTML with Gumbo\n";
+  if (tagScannerEnabled() && scanBetriPage(html, propType, rawProperties)) {
     return rawProperties;
   }
-
-  // 3. Recursively find your property listings
-  findBetriProperties(output->root, betriProperties);
-  gumbo_destroy_output(&kGumboDefaultOptions, output);
-
-  mapBetriToRawProperty(rawProperties, betriProperties, propType);
-  return rawProperties;
+  return parseBetriWithGumbo(html, propType);
 }
 } // namespace HT::BETRI
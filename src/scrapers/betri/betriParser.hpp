@@ -4,8 +4,23 @@
 #include <scrapers/include/house_model.hpp>
 
 namespace HT::BETRI {
-// parse the Html with Gumbo
-std::vector<RawProperty> parseHtmlWithGumboBetri(std::string html,
+// Part of the parse cache key: bump it whenever a change to the parser
+// alters what it returns, so pages parsed by the old code are parsed again
+constexpr int kParserVersion = 1;
+
+// parse the Html with Gumbo. With the tag scanner on (tagScanner.hpp) the
+// scanner reads the page first and Gumbo only gets what it cannot read exactly
+std::vector<RawProperty> parseHtmlWithGumboBetri(const std::string &payload,
                                                  PropertyType propType);
 
+// The class of the <article> that holds one property
+bool isBetriCard(const char *classAttr);
+
+// The two ways parseHtmlWithGumboBetri reads a page. scanBetriPage returns
+// false, with out empty, when the page has to go to Gumbo.
+bool scanBetriPage(const std::string &payload, PropertyType propType,
+                   std::vector<RawProperty> &out);
+std::vector<RawProperty> parseBetriWithGumbo(const std::string &payload,
+                                             PropertyType propType);
+
 } // namespace HT::BETRI
@@ -4,6 +4,7 @@
 #include <nlohmann/json.hpp>
 #include <scrapers/betri/betriScraper.hpp>
 #include <scrapers/include/PropertyManager.hpp>
+#include <scrapers/include/fetchEngine.hpp>
 #include <scrapers/include/filesystem.hpp>
 #include <scrapers/include/house_model.hpp>
 #include <scrapers/include/jsonHelper.hpp>
@@ -13,48 +14,82 @@
 
 namespace HT {
 
-int betriRun(bool downloadNewHtml) {
+namespace {
 
-  // 1. Try to load HTML from "../src/raw_html/html_1.json", or download if
-  // missing
+// "skip=<listings>,<second counter>"; only the first one moves while paging
+std::string betriPageUrl(const std::string &query, size_t offset) {
+  return query + "&skip=" + std::to_string(offset) + ",0";
+}
+
+// Every card carries its listing id in the favourite button
+std::vector<std::string> betriCardIds(const std::string &html) {
+  static const std::string needle = "data-fav-id=\"";
+  std::vector<std::string> ids;
+  for (size_t pos = html.find(needle); pos != std::string::npos;
+       pos = html.find(needle, pos)) {
+    pos += needle.size();
+    const size_t end = html.find('"', pos);
+    if (end == std::string::npos) {
+      break;
+    }
+    ids.push_back(html.substr(pos, end - pos));
+    pos = end;
+  }
+  return ids;
+}
 
-  const std::string url = "https://www.betriheim.fo/";
+} // namespace
 
+// Every Betri property type is a separate, paged query against the filter
+// API. The first page keeps its historical "skip=0,0" url so snapshots of
+// the full result set line up with the older single-page ones.
+std::vector<PagedJob> betriJobs() {
+  std::vector<std::pair<std::string, PropertyType>> queries = {
+      {"https://www.betriheim.fo/api/properties/"
+       "filter?area=&type=Seth%C3%BAs",
+       PropertyType::Sethus},
+      {"https://www.betriheim.fo/api/properties/"
+       "filter?area=&type=Tv%C3%ADh%C3%BAs",
+       PropertyType::Tvihus},
+      {"https://www.betriheim.fo/api/properties/"
+       "filter?area=&type=Ra%C3%B0h%C3%BAs%20/%20Randarh%C3%BAs",
+       PropertyType::Radhus},
+      {"https://www.betriheim.fo/api/properties/"
+       "filter?area=&type=%C3%8Db%C3%BA%C3%B0",
+       PropertyType::Ibud},
+      {"https://www.betriheim.fo/api/properties/"
+       "filter?area=&type=Summarh%C3%BAs%20/"
+       "%20Fr%C3%ADt%C3%AD%C3%B0arh%C3%BAs",
+       PropertyType::Summarhus},
+      {"https://www.betriheim.fo/api/properties/"
+       "filter?area=&type=Vinnubygningur",
+       PropertyType::Vinnubygningur},
+      {"https://www.betriheim.fo/api/properties/"
+       "filter?area=&type=Grundstykki",
+       PropertyType::Grundstykki},
+      {"https://www.betriheim.fo/api/properties/"
+       "filter?area=&type=J%C3%B8r%C3%B0",
+       PropertyType::Jord},
+      {"https://www.betriheim.fo/api/properties/"
+       "filter?area=&type=Neyst",
+       PropertyType::Neyst}};
+
+  std::vector<PagedJob> jobs;
+  for (const auto &[query, type] : queries) {
+    PagedJob job;
+    job.first = {betriPageUrl(query, 0), type, RealEstateAgent::Betri, {}};
+    job.pageUrl = [query](size_t offset) {
+      return betriPageUrl(query, offset);
+    };
+    job.itemIds = betriCardIds;
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+int betriRun(bool downloadNewHtml, const FetchOptions &options) {
   if (downloadNewHtml) {
-    std::vector<std::pair<std::string, PropertyType>> urls = {
-        {"https://www.betriheim.fo/api/properties/"
-         "filter?area=&type=Seth%C3%BAs&skip=0,0",
-         PropertyType::Sethus},
-        {"https://www.betriheim.fo/api/properties/"
-         "filter?area=&type=Tv%C3%ADh%C3%BAs&skip=0,0",
-         PropertyType::Tvihus},
-        {"https://www.betriheim.fo/api/properties/"
-         "filter?area=&type=Ra%C3%B0h%C3%BAs%20/%20Randarh%C3%BAs&skip=0,0",
-         PropertyType::Radhus},
-        {"https://www.betriheim.fo/api/properties/"
-         "filter?area=&type=%C3%8Db%C3%BA%C3%B0&skip=0,0",
-         PropertyType::Ibud},
-        {"https://www.betriheim.fo/api/properties/"
-         "filter?area=&type=Summarh%C3%BAs%20/"
-         "%20Fr%C3%ADt%C3%AD%C3%B0arh%C3%BAs&skip=0,0",
-         PropertyType::Summarhus},
-        {"https://www.betriheim.fo/api/properties/"
-         "filter?area=&type=Vinnubygningur&skip=0,0",
-         PropertyType::Vinnubygningur},
-        {"https://www.betriheim.fo/api/properties/"
-         "filter?area=&type=Grundstykki&skip=0,0",
-         PropertyType::Grundstykki},
-        {"https://www.betriheim.fo/api/properties/"
-         "filter?area=&type=J%C3%B8r%C3%B0&skip=0,0",
-         PropertyType::Jord},
-        {"https://www.betriheim.fo/api/properties/"
-         "filter?area=&type=Neyst&skip=0,0",
-         PropertyType::Neyst}};
-
-    for (const auto &[url, type] : urls) {
-      std::string html =
-          HT::downloadAndSaveHtml(url, type, RealEstateAgent::Betri);
-    }
+    HT::fetchAndSaveAll({}, options, betriJobs());
   }
 
   return 0;
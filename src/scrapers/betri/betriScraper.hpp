@@ -1,8 +1,10 @@
 // betriScraper.hpp
 #pragma once
+#include <scrapers/include/fetchEngine.hpp>
 #include <scrapers/include/house_model.hpp>
 namespace HT {
 std::string loadHtmlFromCacheOrDownload(const std::string &url,
                                         const std::string &filePath);
-int betriRun(bool downloadNewHtml);
+std::vector<PagedJob> betriJobs();
+int betriRun(bool downloadNewHtml, const FetchOptions &options = {});
 } // namespace HT
@@ -0,0 +1,189 @@
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <scrapers/include/blobStore.hpp>
+#include <scrapers/include/filesystem.hpp>
+#include <scrapers/include/hash.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
+
+namespace HT {
+namespace fs = std::filesystem;
+
+static fs::path blobDir(const fs::path &rawHtmlDir) {
+  return rawHtmlDir / "blobs";
+}
+
+fs::path blobPathForHash(const fs::path &rawHtmlDir, const std::string &hash) {
+  return blobDir(rawHtmlDir) / hash.substr(0, 2) / (hash + ".html");
+}
+
+BlobWriter::BlobWriter(const fs::path &rawHtmlDir) : rawHtmlDir(rawHtmlDir) {}
+
+BlobWriter::~BlobWriter() { abort(); }
+
+bool BlobWriter::write(const char *data, size_t size) {
+  if (failed) {
+    return false;
+  }
+  if (!ofs.is_open()) {
+    // Temp files live next to the blobs so the final rename never has to
+    // cross a filesystem; the counter keeps concurrent writers apart
+    static std::atomic<uint64_t> counter{0};
+    std::error_code ec;
+    fs::create_directories(blobDir(rawHtmlDir), ec);
+    tmpPath = blobDir(rawHtmlDir) /
+              ("incoming-" +
+               std::to_string(std::chrono::steady_clock::now()
+                                  .time_since_epoch()
+                                  .count()) +
+               "-" + std::to_string(counter++) + ".tmp");
+    ofs.open(tmpPath, std::ios::binary);
+    if (!ofs.is_open()) {
+      std::cerr << "Error opening file: " << tmpPath << std::endl;
+      failed = true;
+      return false;
+    }
+  }
+
+  ofs.write(data, static_cast<std::streamsize>(size));
+  if (!ofs) {
+    std::cerr << "Error writing file: " << tmpPath << std::endl;
+    failed = true;
+    return false;
+  }
+  sha.update(data, size);
+  bytesWritten += size;
+  return true;
+}
+
+std::string BlobWriter::commit() {
+  if (failed) {
+    abort();
+    return "";
+  }
+  // An empty body still needs its temp file to commit
+  if (!ofs.is_open() && !write("", 0)) {
+    return "";
+  }
+  ofs.close();
+  if (!ofs) {
+    std::cerr << "Error writing file: " << tmpPath << std::endl;
+    abort();
+    return "";
+  }
+
+  const std::string hash = sha.hexDigest();
+  const fs::path path = blobPathForHash(rawHtmlDir, hash);
+  std::error_code ec;
+  if (fs::exists(path)) {
+    fs::remove(tmpPath, ec); // same content already stored by an earlier run
+    tmpPath.clear();
+    return hash;
+  }
+
+  // Renaming the finished file means a crash never leaves a truncated blob
+  // under a valid hash
+  fs::create_directories(path.parent_path(), ec);
+  fs::rename(tmpPath, path, ec);
+  if (ec) {
+    std::cerr << "Error renaming " << tmpPath << ": " << ec.message() << "\n";
+    abort();
+    return "";
+  }
+  tmpPath.clear();
+  return hash;
+}
+
+void BlobWriter::abort() {
+  if (ofs.is_open()) {
+    ofs.close();
+  }
+  if (!tmpPath.empty()) {
+    std::error_code ec;
+    fs::remove(tmpPath, ec);
+    tmpPath.clear();
+  }
+  failed = true;
+}
+
+std::string storeBlob(const fs::path &rawHtmlDir, const std::string &body) {
+  BlobWriter writer(rawHtmlDir);
+  if (!writer.write(body.data(), body.size())) {
+    return "";
+  }
+  return writer.commit();
+}
+
+bool loadBlob(const fs::path &rawHtmlDir, const std::string &hash,
+              std::string &body) {
+  const fs::path path = blobPathForHash(rawHtmlDir, hash);
+  std::error_code ec;
+  const auto size = fs::file_size(path, ec);
+  std::ifstream ifs(path, std::ios::binary);
+  if (ec || !ifs.is_open()) {
+    return false;
+  }
+  // Read straight into the caller's buffer, reusing its capacity
+  body.resize(static_cast<size_t>(size));
+  ifs.read(body.data(), static_cast<std::streamsize>(size));
+  body.resize(static_cast<size_t>(ifs.gcount()));
+  return true;
+}
+
+int migrateLegacySnapshots(const std::string &rawHtmlDir) {
+  int converted = 0;
+
+  for (const auto &path : gatherJsonFiles(rawHtmlDir)) {
+    nlohmann::json j;
+    {
+      std::ifstream ifs(path);
+      try {
+        ifs >> j;
+      } catch (...) {
+        std::cerr << "Skipping unreadable " << path << "\n";
+        continue;
+      }
+    }
+    if (!j.contains("html") || !j["html"].is_string()) {
+      continue; // already an entry (or a 304 marker)
+    }
+
+    const std::string hash =
+        storeBlob(rawHtmlDir, j["html"].get<std::string>());
+    if (hash.empty()) {
+      continue;
+    }
+    j.erase("html");
+    j["hash"] = hash;
+
+    fs::path tmpPath = path;
+    tmpPath += ".tmp";
+    {
+      std::ofstream ofs(tmpPath);
+      if (!ofs.is_open()) {
+        std::cerr << "Error opening file: " << tmpPath << std::endl;
+        continue;
+      }
+      ofs << j.dump(4);
+    }
+    std::error_code ec;
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+      std::cerr << "Error renaming " << tmpPath << ": " << ec.message()
+                << "\n";
+      continue;
+    }
+    ++converted;
+  }
+
+  std::cout << "Converted " << converted << " snapshots to blob entries\n";
+  if (converted > 0) {
+    rebuildManifest(rawHtmlDir); // converted entries are no longer inline
+  }
+  return converted;
+}
+
+} // namespace HT
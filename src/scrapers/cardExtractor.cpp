@@ -0,0 +1,177 @@
+#include <cstring>
+#include <scrapers/include/cardExtractor.hpp>
+#include <scrapers/include/parser.hpp>
+
+namespace HT {
+namespace {
+
+bool isClassSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+// Calls f with every class in classAttr until it returns false
+template <typename F> void forEachClass(const char *classAttr, F f) {
+  const char *p = classAttr;
+  while (*p) {
+    while (*p && isClassSpace(*p)) {
+      ++p;
+    }
+    const char *start = p;
+    while (*p && !isClassSpace(*p)) {
+      ++p;
+    }
+    if (p > start && !f(std::string_view(start, p - start))) {
+      return;
+    }
+  }
+}
+
+const char *findImgSrc(GumboNode *node) {
+  if (!node || node->type != GUMBO_NODE_ELEMENT)
+    return nullptr;
+
+  if (node->v.element.tag == GUMBO_TAG_IMG) {
+    const char *src = getAttribute(&node->v.element.attributes, "src");
+    return src;
+  }
+  GumboVector *kids = &node->v.element.children;
+  for (unsigned i = 0; i < kids->length; ++i)
+    if (const char *s = findImgSrc(static_cast<GumboNode *>(kids->data[i])))
+      return s;
+
+#if GUMBO_VERSION >= 0x000a03
+  if (node->v.element.template_contents) { // dive into <template>
+    if (const char *s = findImgSrc(
+            static_cast<GumboNode *>(node->v.element.template_contents)))
+      return s;
+  }
+#endif
+  return nullptr;
+}
+
+} // namespace
+
+CardExtractor::CardExtractor(CardSpec spec) : spec(std::move(spec)) {
+  const auto &fields = this->spec.fields;
+  for (int i = 0; i < static_cast<int>(fields.size()); ++i) {
+    switch (fields[i].match) {
+    case ClassMatch::Whole:
+      wholeIndex.emplace(fields[i].className, i); // the first one stays
+      break;
+    case ClassMatch::Token:
+      tokenIndex.emplace(fields[i].className, i);
+      break;
+    case ClassMatch::Substring:
+      substringFields.push_back(i);
+      break;
+    }
+  }
+}
+
+void CardExtractor::extract(GumboNode *card, RawProperty &property) const {
+  visit(card, property);
+}
+
+void CardExtractor::visit(GumboNode *node, RawProperty &property) const {
+  if (!node || node->type != GUMBO_NODE_ELEMENT) {
+    return;
+  }
+
+  const char *classAttr = getClassAttr(node);
+  if (classAttr) {
+    const int field = matchField(classAttr);
+    if (field >= 0) {
+      readField(spec.fields[field], node, property);
+    }
+  }
+  readImage(node, classAttr, property);
+
+  GumboVector *children = &node->v.element.children;
+  for (unsigned int i = 0; i < children->length; ++i) {
+    visit(static_cast<GumboNode *>(children->data[i]), property);
+  }
+}
+
+int CardExtractor::matchField(const char *classAttr) const {
+  int best = -1;
+  auto consider = [&](int index) {
+    if (best < 0 || index < best) {
+      best = index;
+    }
+  };
+
+  if (!wholeIndex.empty()) {
+    auto it = wholeIndex.find(classAttr);
+    if (it != wholeIndex.end()) {
+      consider(it->second);
+    }
+  }
+  if (!tokenIndex.empty()) {
+    forEachClass(classAttr, [&](std::string_view cls) {
+      auto it = tokenIndex.find(cls);
+      if (it != tokenIndex.end()) {
+        consider(it->second);
+      }
+      return true;
+    });
+  }
+  for (int index : substringFields) {
+    if (best >= 0 && best < index) {
+      break; // a field listed earlier already matched
+    }
+    if (std::strstr(classAttr, spec.fields[index].className)) {
+      consider(index);
+      break;
+    }
+  }
+  return best;
+}
+
+void CardExtractor::readField(const FieldSpec &field, GumboNode *node,
+                              RawProperty &property) const {
+  std::string &value = property.*field.field;
+  value.clear();
+  switch (field.source) {
+  case FieldSource::Text:
+    appendNodeText(node, value);
+    break;
+  case FieldSource::ParentText:
+    appendNodeText(node->parent, value);
+    break;
+  case FieldSource::Attribute:
+    if (const char *attr =
+            getAttribute(&node->v.element.attributes, field.attribute)) {
+      value = attr;
+    }
+    break;
+  }
+}
+
+void CardExtractor::readImage(GumboNode *node, const char *classAttr,
+                              RawProperty &property) const {
+  const ImageSpec &image = spec.image;
+  if (node->v.element.tag != image.tag ||
+      (image.firstWins && !property.img.empty())) {
+    return;
+  }
+  if (image.className &&
+      (!classAttr || std::strcmp(classAttr, image.className) != 0)) {
+    return;
+  }
+  if (image.attribute) {
+    const char *value =
+        getAttribute(&node->v.element.attributes, image.attribute);
+    if (!value || std::strcmp(value, image.value) != 0) {
+      return;
+    }
+  }
+
+  const char *src = findImgSrc(node);
+  if (!src || (image.srcContains && !std::strstr(src, image.srcContains))) {
+    return;
+  }
+  property.img = image.prefix;
+  property.img += src;
+}
+
+} // namespace HT
@@ -0,0 +1,281 @@
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <scrapers/include/changeEvents.hpp>
+#include <sstream>
+
+namespace HT {
+namespace fs = std::filesystem;
+
+namespace {
+
+const char *const kKindNames[] = {"new",          "price-up",     "price-down",
+                                  "offer-change", "agent-change", "city-change",
+                                  "relisted",     "archived"};
+constexpr size_t kKindCount = sizeof(kKindNames) / sizeof(kKindNames[0]);
+
+void putU32(std::string &out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+void putI64(std::string &out, long long value) {
+  const uint64_t bits = static_cast<uint64_t>(value);
+  for (int i = 0; i < 8; ++i) {
+    out.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+  }
+}
+
+void putString(std::string &out, const std::string &s) {
+  putU32(out, static_cast<uint32_t>(s.size()));
+  out += s;
+}
+
+uint32_t getU32(const char *data) {
+  uint32_t value = 0;
+  for (int i = 3; i >= 0; --i) {
+    value = (value << 8) | static_cast<unsigned char>(data[i]);
+  }
+  return value;
+}
+
+// Reads fields of a payload in order; ok turns false once one runs past
+// its end
+struct PayloadReader {
+  const char *data;
+  size_t size;
+  size_t pos = 0;
+  bool ok = true;
+
+  long long i64() {
+    if (!ok || size - pos < 8) {
+      ok = false;
+      return 0;
+    }
+    uint64_t bits = 0;
+    for (int i = 7; i >= 0; --i) {
+      bits = (bits << 8) | static_cast<unsigned char>(data[pos + i]);
+    }
+    pos += 8;
+    return static_cast<long long>(bits);
+  }
+
+  std::string string() {
+    if (!ok || size - pos < 4) {
+      ok = false;
+      return "";
+    }
+    const size_t length = getU32(data + pos);
+    pos += 4;
+    if (size - pos < length) {
+      ok = false;
+      return "";
+    }
+    pos += length;
+    return std::string(data + pos - length, length);
+  }
+};
+
+std::string encodeEvent(const ChangeEvent &event) {
+  std::string payload;
+  payload.push_back(static_cast<char>(event.kind));
+  putI64(payload, event.timestamp);
+  putString(payload, event.source);
+  putString(payload, event.id);
+  putI64(payload, event.oldValue);
+  putI64(payload, event.newValue);
+  putString(payload, event.oldText);
+  putString(payload, event.newText);
+
+  std::string out;
+  putU32(out, static_cast<uint32_t>(payload.size()));
+  out += payload;
+  putU32(out, static_cast<uint32_t>(payload.size()));
+  return out;
+}
+
+bool decodeEvent(const char *data, size_t size, ChangeEvent &event) {
+  if (size < 1 || static_cast<uint8_t>(data[0]) >= kKindCount) {
+    return false;
+  }
+  event.kind = static_cast<ChangeKind>(data[0]);
+  PayloadReader reader{data, size, 1};
+  event.timestamp = reader.i64();
+  event.source = reader.string();
+  event.id = reader.string();
+  event.oldValue = reader.i64();
+  event.newValue = reader.i64();
+  event.oldText = reader.string();
+  event.newText = reader.string();
+  return reader.ok && reader.pos == size;
+}
+
+// The newest event in the log, read from the end of the file
+bool readLastEvent(const std::string &path, ChangeEvent &event) {
+  std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+  if (!ifs.is_open()) {
+    return false;
+  }
+  const std::streamoff fileSize = ifs.tellg();
+  if (fileSize < 8) {
+    return false;
+  }
+  char sizeBytes[4];
+  ifs.seekg(fileSize - 4);
+  ifs.read(sizeBytes, 4);
+  const std::streamoff payloadSize = getU32(sizeBytes);
+  if (!ifs || payloadSize + 8 > fileSize) {
+    return false;
+  }
+  std::string payload(static_cast<size_t>(payloadSize), '\0');
+  ifs.seekg(fileSize - 4 - payloadSize);
+  ifs.read(payload.data(), payloadSize);
+  return ifs && decodeEvent(payload.data(), payload.size(), event);
+}
+
+std::string formatTimestamp(long long timestamp) {
+  std::time_t t = static_cast<std::time_t>(timestamp);
+  std::tm tm{};
+#ifdef _WIN32
+  localtime_s(&tm, &t);
+#else
+  localtime_r(&t, &tm);
+#endif
+  std::ostringstream oss;
+  oss << std::put_time(&tm, "%Y-%m-%d %H:%M");
+  return oss.str();
+}
+
+} // namespace
+
+std::string changeKindToString(ChangeKind kind) {
+  const size_t index = static_cast<size_t>(kind);
+  return index < kKindCount ? kKindNames[index] : "unknown";
+}
+
+bool changeKindFromString(const std::string &str, ChangeKind &kind) {
+  for (size_t i = 0; i < kKindCount; ++i) {
+    if (str == kKindNames[i]) {
+      kind = static_cast<ChangeKind>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+int appendChangeEvents(const std::vector<ChangeEvent> &events,
+                       const std::string &path) {
+  std::error_code ec;
+  ChangeEvent newest;
+  bool hasNewest = readLastEvent(path, newest);
+  if (!hasNewest && fs::file_size(path, ec) > 0 && !ec) {
+    // A crash cut the last event short: keep the whole ones
+    const std::vector<ChangeEvent> logged = readChangeEvents(path);
+    std::string kept;
+    for (const auto &event : logged) {
+      kept += encodeEvent(event);
+    }
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(kept.data(), static_cast<std::streamsize>(kept.size()));
+    if (!ofs) {
+      std::cerr << "Error writing file: " << path << std::endl;
+      return -1;
+    }
+    if (!logged.empty()) {
+      newest = logged.back();
+      hasNewest = true;
+    }
+  }
+
+  std::string out;
+  int count = 0;
+  for (const auto &event : events) {
+    if (hasNewest && event.source <= newest.source) {
+      continue; // logged by an earlier run
+    }
+    out += encodeEvent(event);
+    ++count;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  fs::create_directories(fs::path(path).parent_path(), ec);
+  std::ofstream ofs(path, std::ios::binary | std::ios::app);
+  ofs.write(out.data(), static_cast<std::streamsize>(out.size()));
+  if (!ofs) {
+    std::cerr << "Error writing file: " << path << std::endl;
+    return -1;
+  }
+  return count;
+}
+
+std::vector<ChangeEvent> readChangeEvents(const std::string &path) {
+  std::vector<ChangeEvent> events;
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs.is_open()) {
+    return events;
+  }
+  const std::string data((std::istreambuf_iterator<char>(ifs)),
+                         std::istreambuf_iterator<char>());
+
+  size_t pos = 0;
+  while (data.size() - pos >= 8) {
+    const size_t payloadSize = getU32(data.data() + pos);
+    if (data.size() - pos - 8 < payloadSize ||
+        getU32(data.data() + pos + 4 + payloadSize) != payloadSize) {
+      std::cerr << "Ignoring " << data.size() - pos
+                << " unreadable bytes at the end of " << path << "\n";
+      break;
+    }
+    ChangeEvent event;
+    if (decodeEvent(data.data() + pos + 4, payloadSize, event)) {
+      events.push_back(std::move(event));
+    }
+    pos += payloadSize + 8;
+  }
+  return events;
+}
+
+int printChangeEvents(const ChangeQuery &query, const std::string &path) {
+  ChangeKind kind = ChangeKind::New;
+  if (!query.kind.empty() && !changeKindFromString(query.kind, kind)) {
+    std::cerr << "Unknown event kind: " << query.kind << "\n";
+    return 1;
+  }
+
+  for (const auto &event : readChangeEvents(path)) {
+    if ((!query.id.empty() && event.id != query.id) ||
+        (!query.kind.empty() && event.kind != kind)) {
+      continue;
+    }
+    // "YYYY-MM-DD HH:MM" sorts like the time it shows
+    const std::string when = formatTimestamp(event.timestamp);
+    if (when < query.since) {
+      continue;
+    }
+    std::cout << when << "  "
+              << changeKindToString(event.kind) << "  " << event.id;
+    switch (event.kind) {
+    case ChangeKind::PriceUp:
+    case ChangeKind::PriceDown:
+    case ChangeKind::OfferChange:
+      std::cout << "  " << event.oldValue << " -> " << event.newValue;
+      break;
+    case ChangeKind::AgentChange:
+    case ChangeKind::CityChange:
+      std::cout << "  " << event.oldText << " -> " << event.newText;
+      break;
+    default:
+      break;
+    }
+    std::cout << "\n";
+  }
+  return 0;
+}
+
+} // namespace HT
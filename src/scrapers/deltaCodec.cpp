@@ -0,0 +1,276 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <scrapers/include/deltaCodec.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace HT {
+
+namespace {
+
+constexpr size_t kWindow = 32; // bytes a match must share to be found
+constexpr size_t kStep = 16;   // base positions indexed
+constexpr uint64_t kPrime = 1099511628211ull;
+
+enum : uint8_t { kAdd = 0, kCopy = 1 };
+
+void putVarint(std::string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(std::string_view data, size_t &pos, uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+    const uint8_t byte = static_cast<uint8_t>(data[pos++]);
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t windowHash(const char *data) {
+  uint64_t hash = 0;
+  for (size_t i = 0; i < kWindow; ++i) {
+    hash = hash * kPrime + static_cast<uint8_t>(data[i]);
+  }
+  return hash;
+}
+
+void putAdd(std::string &out, std::string_view target, size_t from,
+            size_t to) {
+  if (to <= from) {
+    return;
+  }
+  out.push_back(static_cast<char>(kAdd));
+  putVarint(out, to - from);
+  out.append(target.data() + from, to - from);
+}
+
+} // namespace
+
+std::string encodeDelta(std::string_view base, std::string_view target) {
+  std::string out;
+  putVarint(out, target.size());
+  if (base.size() < kWindow || target.size() < kWindow) {
+    putAdd(out, target, 0, target.size());
+    return out;
+  }
+
+  // Hashes of the base windows that start on a kStep boundary. A run the
+  // two versions share is found as long as it spans one of them.
+  std::unordered_map<uint64_t, uint32_t> index;
+  index.reserve(base.size() / kStep + 1);
+  for (size_t pos = 0; pos + kWindow <= base.size(); pos += kStep) {
+    index.emplace(windowHash(base.data() + pos), static_cast<uint32_t>(pos));
+  }
+
+  uint64_t outFactor = 1; // kPrime^(kWindow-1), to roll a byte out
+  for (size_t i = 1; i < kWindow; ++i) {
+    outFactor *= kPrime;
+  }
+
+  size_t literalStart = 0;
+  size_t pos = 0;
+  uint64_t hash = windowHash(target.data());
+  while (pos + kWindow <= target.size()) {
+    auto it = index.find(hash);
+    if (it != index.end() &&
+        std::memcmp(base.data() + it->second, target.data() + pos,
+                    kWindow) == 0) {
+      size_t from = it->second;
+      size_t at = pos;
+      // Grow the match both ways
+      while (at > literalStart && from > 0 && target[at - 1] == base[from - 1]) {
+        --at;
+        --from;
+      }
+      size_t length = pos - at + kWindow;
+      while (at + length < target.size() && from + length < base.size() &&
+             target[at + length] == base[from + length]) {
+        ++length;
+      }
+
+      putAdd(out, target, literalStart, at);
+      out.push_back(static_cast<char>(kCopy));
+      putVarint(out, from);
+      putVarint(out, length);
+      pos = at + length;
+      literalStart = pos;
+      if (pos + kWindow <= target.size()) {
+        hash = windowHash(target.data() + pos);
+      }
+      continue;
+    }
+
+    if (pos + kWindow >= target.size()) {
+      break;
+    }
+    hash = (hash - static_cast<uint8_t>(target[pos]) * outFactor) * kPrime +
+           static_cast<uint8_t>(target[pos + kWindow]);
+    ++pos;
+  }
+  putAdd(out, target, literalStart, target.size());
+  return out;
+}
+
+bool applyDelta(std::string_view base, std::string_view delta,
+                std::string &target) {
+  size_t pos = 0;
+  uint64_t targetSize = 0;
+  if (!getVarint(delta, pos, targetSize)) {
+    return false;
+  }
+  target.clear();
+  target.reserve(targetSize);
+
+  while (pos < delta.size()) {
+    const uint8_t op = static_cast<uint8_t>(delta[pos++]);
+    if (op == kAdd) {
+      uint64_t length = 0;
+      if (!getVarint(delta, pos, length) || length > delta.size() - pos) {
+        return false;
+      }
+      target.append(delta.data() + pos, length);
+      pos += length;
+    } else if (op == kCopy) {
+      uint64_t from = 0;
+      uint64_t length = 0;
+      if (!getVarint(delta, pos, from) || !getVarint(delta, pos, length) ||
+          from > base.size() || length > base.size() - from) {
+        return false;
+      }
+      target.append(base.data() + from, length);
+    } else {
+      return false;
+    }
+  }
+  return target.size() == targetSize;
+}
+
+int benchDeltaEncoding(const std::string &rawHtmlDir, int keyframeInterval) {
+  using Clock = std::chrono::steady_clock;
+  if (keyframeInterval < 1) {
+    keyframeInterval = 1;
+  }
+
+  // Every distinct page, grouped by url in the order it was fetched
+  std::unordered_map<std::string, std::vector<std::string>> pagesByUrl;
+  std::vector<std::string> urls;
+  std::unordered_set<std::string> seenHashes;
+  uint64_t archivedBytes = 0; // as if every fetch kept its own copy
+  for (const auto &record : archivedSnapshotRecords(rawHtmlDir)) {
+    if (record.unchanged) {
+      continue;
+    }
+    archivedBytes += record.size;
+    if (!seenHashes.insert(record.hash).second) {
+      continue;
+    }
+    std::string page;
+    if (!loadSnapshotPage(rawHtmlDir, record, page)) {
+      continue;
+    }
+    auto [it, added] = pagesByUrl.try_emplace(record.url);
+    if (added) {
+      urls.push_back(record.url);
+    }
+    it->second.push_back(std::move(page));
+  }
+  if (urls.empty()) {
+    std::cerr << "No snapshots found in " << rawHtmlDir << "\n";
+    return 1;
+  }
+
+  uint64_t distinctBytes = 0;
+  uint64_t storedBytes = 0;
+  size_t versions = 0;
+  size_t keyframes = 0;
+  std::vector<std::vector<std::string>> encoded; // per url, in order
+  const auto encodeStart = Clock::now();
+  for (const auto &url : urls) {
+    const auto &pages = pagesByUrl[url];
+    auto &stored = encoded.emplace_back();
+    for (size_t i = 0; i < pages.size(); ++i) {
+      distinctBytes += pages[i].size();
+      if (i % keyframeInterval == 0) {
+        stored.push_back(pages[i]);
+        ++keyframes;
+      } else {
+        stored.push_back(encodeDelta(pages[i - 1], pages[i]));
+      }
+      storedBytes += stored.back().size();
+      ++versions;
+    }
+  }
+  const double encodeSeconds =
+      std::chrono::duration<double>(Clock::now() - encodeStart).count();
+
+  // Ingest rebuilds the versions of a url in order, so each delta is
+  // applied to the version just before it
+  std::string previous;
+  std::string current;
+  size_t mismatches = 0;
+  const auto decodeStart = Clock::now();
+  for (size_t u = 0; u < urls.size(); ++u) {
+    const auto &stored = encoded[u];
+    for (size_t i = 0; i < stored.size(); ++i) {
+      if (i % keyframeInterval == 0) {
+        current = stored[i];
+      } else if (!applyDelta(previous, stored[i], current)) {
+        ++mismatches;
+      }
+      std::swap(previous, current);
+    }
+  }
+  const double decodeSeconds =
+      std::chrono::duration<double>(Clock::now() - decodeStart).count();
+
+  // Check every version round-trips
+  for (size_t u = 0; u < urls.size(); ++u) {
+    const auto &pages = pagesByUrl[urls[u]];
+    for (size_t i = 0; i < pages.size(); ++i) {
+      if (i % keyframeInterval == 0) {
+        continue;
+      }
+      if (!applyDelta(pages[i - 1], encoded[u][i], current) ||
+          current != pages[i]) {
+        ++mismatches;
+      }
+    }
+  }
+
+  const double mb = distinctBytes / (1024.0 * 1024.0);
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << urls.size() << " urls, " << versions << " distinct pages ("
+            << keyframes << " keyframes, interval " << keyframeInterval
+            << ")\n";
+  std::cout << "Archived: " << archivedBytes << " bytes, distinct pages: "
+            << distinctBytes << " bytes, delta-encoded: " << storedBytes
+            << " bytes\n";
+  std::cout << "Compression: "
+            << (storedBytes ? double(distinctBytes) / storedBytes : 0.0)
+            << "x over distinct pages, "
+            << (storedBytes ? double(archivedBytes) / storedBytes : 0.0)
+            << "x over one copy per fetch\n";
+  std::cout << "Encode: " << (encodeSeconds > 0 ? mb / encodeSeconds : 0.0)
+            << " MB/s, reconstruct: "
+            << (decodeSeconds > 0 ? mb / decodeSeconds : 0.0) << " MB/s\n";
+  if (mismatches > 0) {
+    std::cerr << mismatches << " versions did not round-trip\n";
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace HT
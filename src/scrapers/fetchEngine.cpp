@@ -0,0 +1,681 @@
+#include <algorithm>
+#include <curl/curl.h>
+#include <iostream>
+#include <memory>
+#include <scrapers/include/blobStore.hpp>
+#include <scrapers/include/fetchEngine.hpp>
+#include <scrapers/include/filesystem.hpp>
+#include <scrapers/include/httpClient.hpp>
+#include <scrapers/include/scraper.hpp>
+#include <scrapers/include/snapshotStream.hpp>
+#include <scrapers/include/validatorStore.hpp>
+#include <unordered_set>
+
+namespace HT {
+
+struct FetchEngine::Transfer {
+  FetchResult result;
+  FetchCallback onDone;
+  DataCallback onData;
+  uint64_t decodedBytes = 0;
+  uint64_t deliveredBytes = 0; // handed to onData or the body
+  bool statusChecked = false;
+  bool discardBody = false; // error page of a response that will be retried
+  std::string host;
+  CURL *easy = nullptr;
+  curl_slist *headers = nullptr;
+};
+
+static bool isRetryableStatus(long httpStatus) {
+  return httpStatus == 429 || (httpStatus >= 500 && httpStatus <= 599);
+}
+
+static bool isRetryableError(CURLcode code) {
+  switch (code) {
+  case CURLE_COULDNT_RESOLVE_HOST:
+  case CURLE_COULDNT_CONNECT:
+  case CURLE_OPERATION_TIMEDOUT:
+  case CURLE_SSL_CONNECT_ERROR:
+  case CURLE_SEND_ERROR:
+  case CURLE_RECV_ERROR:
+  case CURLE_GOT_NOTHING:
+  case CURLE_PARTIAL_FILE:
+  case CURLE_HTTP2:
+  case CURLE_HTTP2_STREAM:
+    return true;
+  default:
+    return false;
+  }
+}
+
+size_t FetchEngine::writeBody(char *data, size_t size, size_t nmemb,
+                              void *userp) {
+  size_t totalBytes = size * nmemb;
+  auto *transfer = static_cast<Transfer *>(userp);
+  transfer->decodedBytes += totalBytes;
+
+  // Keep the error page of a 429/5xx out of the sink, so the request can
+  // still be retried from scratch
+  if (!transfer->statusChecked) {
+    transfer->statusChecked = true;
+    long httpStatus = 0;
+    curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &httpStatus);
+    transfer->discardBody = isRetryableStatus(httpStatus);
+  }
+  if (transfer->discardBody) {
+    return totalBytes;
+  }
+
+  transfer->deliveredBytes += totalBytes;
+  if (transfer->onData) {
+    // Anything but totalBytes makes curl fail the transfer
+    return transfer->onData(data, totalBytes) ? totalBytes : 0;
+  }
+  transfer->result.body.append(data, totalBytes);
+  return totalBytes;
+}
+
+// Picks the cache validators out of the response headers
+static size_t FetchHeaderCallback(char *buffer, size_t size, size_t nitems,
+                                  void *userp) {
+  size_t totalBytes = size * nitems;
+  auto *result = static_cast<FetchResult *>(userp);
+  std::string line(buffer, totalBytes);
+
+  // A new status line means a redirect or 100-continue; start over
+  if (line.rfind("HTTP/", 0) == 0) {
+    result->etag.clear();
+    result->lastModified.clear();
+    return totalBytes;
+  }
+
+  auto colon = line.find(':');
+  if (colon == std::string::npos) {
+    return totalBytes;
+  }
+  std::string name = line.substr(0, colon);
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  auto valueStart = line.find_first_not_of(" \t", colon + 1);
+  auto valueEnd = line.find_last_not_of("\r\n");
+  std::string value =
+      (valueStart == std::string::npos || valueEnd < valueStart)
+          ? ""
+          : line.substr(valueStart, valueEnd - valueStart + 1);
+
+  if (name == "etag") {
+    result->etag = value;
+  } else if (name == "last-modified") {
+    result->lastModified = value;
+  }
+  return totalBytes;
+}
+
+// "https://www.skyn.fo/ognir?x=1" -> "www.skyn.fo"
+std::string hostFromUrl(const std::string &url) {
+  auto start = url.find("://");
+  start = (start == std::string::npos) ? 0 : start + 3;
+  auto end = url.find_first_of(":/?#", start);
+  return url.substr(start, end == std::string::npos ? std::string::npos
+                                                    : end - start);
+}
+
+std::string replayPathForUrl(const std::string &url) {
+  auto start = url.find("://");
+  start = (start == std::string::npos) ? 0 : start + 3;
+  return "/" + url.substr(start);
+}
+
+void applyFetchTimeouts(CURL *easy, const FetchOptions &options) {
+  curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, options.connectTimeoutMs);
+  curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, options.requestTimeoutMs);
+  curl_easy_setopt(easy, CURLOPT_LOW_SPEED_LIMIT,
+                   options.lowSpeedBytesPerSecond);
+  curl_easy_setopt(easy, CURLOPT_LOW_SPEED_TIME, options.lowSpeedSeconds);
+}
+
+FetchEngine::FetchEngine(FetchOptions options) : options(options) {
+  this->options.maxInFlight = std::max(1, this->options.maxInFlight);
+  this->options.maxInFlightPerHost =
+      std::max(1, this->options.maxInFlightPerHost);
+  this->options.maxRetries = std::max(0, this->options.maxRetries);
+  multi = curl_multi_init();
+  if (!multi) {
+    std::cerr << "Failed to init curl multi handle\n";
+    return;
+  }
+  // Lets transfers to the same host share one HTTP/2 connection
+  curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+}
+
+FetchEngine::~FetchEngine() {
+  for (auto &[ptr, transfer] : running) {
+    curl_multi_remove_handle(multi, transfer->easy);
+    HttpClient::instance().release(transfer->easy, transfer->decodedBytes);
+    curl_slist_free_all(transfer->headers);
+  }
+  if (multi) {
+    curl_multi_cleanup(multi);
+  }
+}
+
+void FetchEngine::add(FetchJob job, FetchCallback onDone,
+                      DataCallback onData) {
+  auto transfer = std::make_unique<Transfer>();
+  transfer->host = hostFromUrl(job.url);
+  transfer->result.job = std::move(job);
+  transfer->onDone = std::move(onDone);
+  transfer->onData = std::move(onData);
+  queued.push_back(std::move(transfer));
+}
+
+bool FetchEngine::hostGivenUp(const std::string &host) const {
+  auto it = failuresInARowByHost.find(host);
+  return options.hostFailureLimit > 0 && it != failuresInARowByHost.end() &&
+         it->second >= options.hostFailureLimit;
+}
+
+// Moves queued jobs onto the multi handle while both the global and the
+// per-host limits allow it. Jobs for a saturated host keep their place in
+// the queue so other hosts are not held up behind them.
+void FetchEngine::startQueuedTransfers() {
+  // Callbacks may add() jobs, so failures are reported after the loop
+  std::vector<std::unique_ptr<Transfer>> failed;
+  const Clock::time_point now = Clock::now();
+
+  for (auto it = queued.begin(); it != queued.end();) {
+    if (static_cast<int>(running.size()) >= options.maxInFlight) {
+      break;
+    }
+    Transfer *transfer = it->get();
+    if (hostGivenUp(transfer->host)) {
+      transfer->result.error = "skipped, " + transfer->host +
+                               " failed too often in this run";
+      failed.push_back(std::move(*it));
+      it = queued.erase(it);
+      continue;
+    }
+    int &hostCount = inFlightByHost[transfer->host];
+    if (hostCount >= options.maxInFlightPerHost) {
+      ++it;
+      continue;
+    }
+
+    transfer->easy = HttpClient::instance().acquire();
+    if (!transfer->easy) {
+      (*it)->result.error = "curl_easy_init failed";
+      failed.push_back(std::move(*it));
+      it = queued.erase(it);
+      continue;
+    }
+
+    const std::string &url = transfer->result.job.url;
+    const std::string requestUrl =
+        options.replayEndpoint.empty()
+            ? url
+            : options.replayEndpoint + replayPathForUrl(url);
+    curl_easy_setopt(transfer->easy, CURLOPT_URL, requestUrl.c_str());
+    curl_easy_setopt(transfer->easy, CURLOPT_WRITEFUNCTION, writeBody);
+    curl_easy_setopt(transfer->easy, CURLOPT_WRITEDATA, transfer);
+    curl_easy_setopt(transfer->easy, CURLOPT_HEADERFUNCTION,
+                     FetchHeaderCallback);
+    curl_easy_setopt(transfer->easy, CURLOPT_HEADERDATA, &transfer->result);
+    for (const auto &header : transfer->result.job.headers) {
+      transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+    }
+    if (transfer->headers) {
+      curl_easy_setopt(transfer->easy, CURLOPT_HTTPHEADER, transfer->headers);
+    }
+
+    // A request never outlives the run deadline
+    applyFetchTimeouts(transfer->easy, options);
+    if (deadline != Clock::time_point::max()) {
+      long timeoutMs = static_cast<long>(
+          std::chrono::duration_cast<std::chrono::milliseconds>(deadline -
+                                                                now)
+              .count());
+      if (options.requestTimeoutMs > 0) {
+        timeoutMs = std::min(timeoutMs, options.requestTimeoutMs);
+      }
+      curl_easy_setopt(transfer->easy, CURLOPT_TIMEOUT_MS,
+                       std::max(1L, timeoutMs));
+    }
+
+    curl_easy_setopt(transfer->easy, CURLOPT_PRIVATE, transfer);
+    curl_multi_add_handle(multi, transfer->easy);
+
+    ++transfer->result.attempts;
+    ++hostCount;
+    running.emplace(transfer, std::move(*it));
+    it = queued.erase(it);
+  }
+
+  for (auto &transfer : failed) {
+    std::cerr << "Fetch failed for " << transfer->result.job.url << ": "
+              << transfer->result.error << "\n";
+    if (transfer->onDone) {
+      transfer->onDone(transfer->result);
+    }
+  }
+}
+
+// Puts a failed attempt back for another try if the policy allows it.
+// Returns false when the failure is final.
+bool FetchEngine::scheduleRetry(std::unique_ptr<Transfer> &transfer,
+                                CURLcode code) {
+  const bool retryable = code == CURLE_OK
+                             ? isRetryableStatus(transfer->result.httpStatus)
+                             : isRetryableError(code);
+  if (!retryable || transfer->deliveredBytes > 0 ||
+      transfer->result.attempts > options.maxRetries ||
+      hostGivenUp(transfer->host)) {
+    return false;
+  }
+
+  std::uniform_real_distribution<double> jitter(0.5, 1.5);
+  const double delayMs = options.retryBackoffMs *
+                         double(1 << std::min(transfer->result.attempts - 1,
+                                              16)) *
+                         jitter(rng);
+  const Clock::time_point readyAt =
+      Clock::now() + std::chrono::milliseconds(static_cast<long>(delayMs));
+  if (readyAt >= deadline) {
+    return false;
+  }
+
+  std::cerr << "Retrying " << transfer->result.job.url << " in "
+            << static_cast<long>(delayMs) << " ms ("
+            << transfer->result.error << ")\n";
+  FetchResult &result = transfer->result;
+  result.httpStatus = 0;
+  result.body.clear();
+  result.error.clear();
+  result.etag.clear();
+  result.lastModified.clear();
+  transfer->decodedBytes = 0;
+  transfer->statusChecked = false;
+  transfer->discardBody = false;
+  ++retries;
+  retrying.emplace_back(readyAt, std::move(transfer));
+  return true;
+}
+
+void FetchEngine::startDueRetries() {
+  const Clock::time_point now = Clock::now();
+  for (auto it = retrying.begin(); it != retrying.end();) {
+    if (it->first <= now) {
+      queued.push_back(std::move(it->second));
+      it = retrying.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void FetchEngine::finishTransfer(Transfer *transfer, CURLcode code) {
+  auto node = running.extract(transfer);
+  std::unique_ptr<Transfer> owned = std::move(node.mapped());
+  --inFlightByHost[owned->host];
+
+  curl_easy_getinfo(owned->easy, CURLINFO_RESPONSE_CODE,
+                    &owned->result.httpStatus);
+  curl_multi_remove_handle(multi, owned->easy);
+  HttpClient::instance().release(owned->easy, owned->decodedBytes);
+  owned->easy = nullptr;
+  curl_slist_free_all(owned->headers);
+  owned->headers = nullptr;
+
+  if (code != CURLE_OK) {
+    owned->result.error = curl_easy_strerror(code);
+  } else if (isRetryableStatus(owned->result.httpStatus)) {
+    owned->result.error = "HTTP " + std::to_string(owned->result.httpStatus);
+  } else {
+    owned->result.success = true;
+  }
+
+  int &failuresInARow = failuresInARowByHost[owned->host];
+  if (owned->result.success) {
+    failuresInARow = 0;
+  } else if (++failuresInARow == options.hostFailureLimit) {
+    std::cerr << "Giving up on " << owned->host << " for this run after "
+              << failuresInARow << " failures in a row\n";
+  }
+
+  if (!owned->result.success) {
+    if (scheduleRetry(owned, code)) {
+      return;
+    }
+    std::cerr << "Fetch failed for " << owned->result.job.url << ": "
+              << owned->result.error << "\n";
+  }
+
+  if (owned->onDone) {
+    owned->onDone(owned->result);
+  }
+}
+
+// Gives up on every job that has not finished yet
+void FetchEngine::failEverything(const std::string &reason) {
+  std::vector<std::unique_ptr<Transfer>> unfinished;
+  for (auto &[ptr, transfer] : running) {
+    curl_multi_remove_handle(multi, transfer->easy);
+    HttpClient::instance().release(transfer->easy, transfer->decodedBytes);
+    transfer->easy = nullptr;
+    curl_slist_free_all(transfer->headers);
+    transfer->headers = nullptr;
+    unfinished.push_back(std::move(transfer));
+  }
+  running.clear();
+  inFlightByHost.clear();
+  for (auto &[readyAt, transfer] : retrying) {
+    unfinished.push_back(std::move(transfer));
+  }
+  retrying.clear();
+  for (auto &transfer : queued) {
+    unfinished.push_back(std::move(transfer));
+  }
+  queued.clear();
+
+  for (auto &transfer : unfinished) {
+    transfer->result.success = false;
+    transfer->result.error = reason;
+    std::cerr << "Fetch failed for " << transfer->result.job.url << ": "
+              << reason << "\n";
+    if (transfer->onDone) {
+      transfer->onDone(transfer->result);
+    }
+  }
+}
+
+void FetchEngine::run() {
+  if (!multi) {
+    return;
+  }
+
+  if (options.runDeadlineMs > 0) {
+    deadline = Clock::now() + std::chrono::milliseconds(options.runDeadlineMs);
+  }
+
+  startQueuedTransfers();
+  while (!running.empty() || !retrying.empty() || !queued.empty()) {
+    if (Clock::now() >= deadline) {
+      // Callbacks may still add jobs; they fail the same way
+      while (!running.empty() || !retrying.empty() || !queued.empty()) {
+        failEverything("run deadline exceeded");
+      }
+      break;
+    }
+
+    int stillRunning = 0;
+    curl_multi_perform(multi, &stillRunning);
+
+    int msgsLeft = 0;
+    while (CURLMsg *msg = curl_multi_info_read(multi, &msgsLeft)) {
+      if (msg->msg != CURLMSG_DONE) {
+        continue;
+      }
+      Transfer *transfer = nullptr;
+      curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+      finishTransfer(transfer, msg->data.result);
+    }
+
+    // Refill the freed slots before waiting, otherwise new transfers
+    // would sit idle until the next socket event
+    startDueRetries();
+    startQueuedTransfers();
+
+    // Wake up for socket events, the next retry or the deadline
+    Clock::time_point wakeAt = std::min(Clock::now() + std::chrono::seconds(1),
+                                        deadline);
+    for (const auto &[readyAt, transfer] : retrying) {
+      wakeAt = std::min(wakeAt, readyAt);
+    }
+    const int waitMs = static_cast<int>(std::max<long long>(
+        0, std::chrono::duration_cast<std::chrono::milliseconds>(
+               wakeAt - Clock::now())
+               .count()));
+    curl_multi_poll(multi, nullptr, 0, waitMs, nullptr);
+  }
+
+  if (retries > 0) {
+    std::cout << "Retried " << retries << " requests\n";
+  }
+  deadline = Clock::time_point::max();
+  retries = 0;
+  failuresInARowByHost.clear();
+}
+
+// Adds If-None-Match / If-Modified-Since when we hold validators for the URL
+static void addConditionalHeaders(FetchJob &job, const ValidatorStore &store) {
+  const Validators *v = store.find(job.url);
+  if (!v) {
+    return;
+  }
+  if (!v->etag.empty()) {
+    job.headers.push_back("If-None-Match: " + v->etag);
+  }
+  if (!v->lastModified.empty()) {
+    job.headers.push_back("If-Modified-Since: " + v->lastModified);
+  }
+}
+
+// Saves a finished download as a snapshot (200) or an unchanged marker
+// (304), drops any other status, and keeps the validator store in step. The body has already been
+// streamed into `stream`; this only commits it. Returns the snapshot path.
+static std::string saveFetchResult(FetchResult &result, SnapshotStream &stream,
+                                   ValidatorStore &store,
+                                   std::string *hashOut) {
+  const FetchJob &job = result.job;
+  if (!result.success) {
+    stream.abort();
+    return "";
+  }
+
+  if (result.httpStatus == 304) {
+    stream.abort();
+    std::cout << "Unchanged since last run: " << job.url << "\n";
+    return saveUnchangedMarker(job.url, job.type, job.agent);
+  }
+
+  // A 403 from a firewall or a 404 error page is not the listing page; as
+  // a snapshot it would mark every listing on the url archived
+  if (result.httpStatus != 200) {
+    stream.abort();
+    std::cerr << "Fetch failed for " << job.url << ": HTTP "
+              << result.httpStatus << "\n";
+    return "";
+  }
+
+  std::string hash = stream.commit();
+  if (hash.empty()) {
+    std::cerr << "Download failed: " << job.url << "\n";
+    return "";
+  }
+
+  std::string path = saveSnapshotEntry(job.url, job.type, job.agent, hash);
+  if (!path.empty()) {
+    store.update(job.url, {result.etag, result.lastModified, path});
+  }
+  if (hashOut) {
+    *hashOut = std::move(hash);
+  }
+  return path;
+}
+
+// Queues a job whose body is written straight into the blob store
+static void addSnapshotJob(FetchEngine &engine, FetchJob job,
+                           ValidatorStore &store,
+                           std::function<void(const std::string &path,
+                                              const std::string &hash)>
+                               onSaved) {
+  addConditionalHeaders(job, store);
+  auto stream = std::make_shared<SnapshotStream>(snapshotDir());
+  engine.add(
+      std::move(job),
+      [stream, &store, onSaved](FetchResult &result) {
+        std::string hash;
+        std::string path = saveFetchResult(result, *stream, store, &hash);
+        if (!path.empty()) {
+          onSaved(path, hash);
+        }
+      },
+      [stream](const char *data, size_t size) {
+        return stream->write(data, size);
+      });
+}
+
+namespace {
+
+// Progress of one PagedJob across its page requests
+struct PagedFetch {
+  PagedJob job;
+  std::vector<std::string> pages; // html by page index, "" if dropped
+  std::unordered_set<std::string> seenIds;
+  size_t itemsSoFar = 0;
+  int outstanding = 0;
+  bool failed = false; // a page failed, or paging hit maxPages
+};
+
+void addPage(FetchEngine &engine, const std::shared_ptr<PagedFetch> &fetch,
+             size_t pageIndex, size_t offset,
+             const std::function<void(PagedFetch &)> &onComplete) {
+  FetchJob job = fetch->job.first;
+  if (pageIndex > 0) {
+    job.url = fetch->job.pageUrl(offset);
+  }
+  if (fetch->pages.size() <= pageIndex) {
+    fetch->pages.resize(pageIndex + 1);
+  }
+  ++fetch->outstanding;
+
+  engine.add(std::move(job), [&engine, fetch, pageIndex,
+                              onComplete](FetchResult &result) {
+    --fetch->outstanding;
+    PagedJob &paged = fetch->job;
+
+    if (!result.success || result.httpStatus != 200) {
+      // A missing later page just means there are no more results
+      if (pageIndex == 0 || result.httpStatus != 404) {
+        fetch->failed = true;
+      }
+    } else {
+      // Pages are small; unwrap the API payload in one go
+      std::string html;
+      HtmlPayloadExtractor extractor([&html](const char *data, size_t size) {
+        html.append(data, size);
+        return true;
+      });
+      extractor.feed(result.body.data(), result.body.size());
+      extractor.finish();
+
+      const std::vector<std::string> ids = paged.itemIds(html);
+      size_t newIds = 0;
+      for (const auto &id : ids) {
+        newIds += fetch->seenIds.insert(id).second ? 1 : 0;
+      }
+      fetch->itemsSoFar += ids.size();
+      if (pageIndex == 0 || newIds > 0) {
+        fetch->pages[pageIndex] = std::move(html);
+      }
+
+      // Keep paging while pages bring results not seen on an earlier one
+      if (newIds > 0) {
+        if (pageIndex + 1 < static_cast<size_t>(paged.maxPages)) {
+          addPage(engine, fetch, pageIndex + 1, fetch->itemsSoFar,
+                  onComplete);
+        } else {
+          // Results were still coming, so the rest were never seen
+          std::cerr << "Stopped paging " << paged.first.url << " after "
+                    << paged.maxPages << " page(s) with results left\n";
+          fetch->failed = true;
+        }
+      }
+    }
+
+    if (fetch->outstanding == 0) {
+      onComplete(*fetch);
+    }
+  });
+}
+
+} // namespace
+
+int fetchAndSaveAll(const std::vector<FetchJob> &jobs,
+                    const FetchOptions &options,
+                    const std::vector<PagedJob> &pagedJobs) {
+  // Validators from a replay server must not end up in requests to the
+  // live sites
+  ValidatorStore store(options.replayEndpoint.empty()
+                           ? "../src/storage/validators.json"
+                           : "../src/storage/replay_validators.json");
+  store.load();
+
+  FetchEngine engine(options);
+  int saved = 0;
+
+  for (const FetchJob &job : jobs) {
+    addSnapshotJob(engine, job, store,
+                   [&saved](const std::string &, const std::string &) {
+                     ++saved;
+                   });
+  }
+
+  // Paged queries are fetched unconditionally: an unchanged first page
+  // says nothing about the pages after it
+  for (const PagedJob &pagedJob : pagedJobs) {
+    auto fetch = std::make_shared<PagedFetch>();
+    fetch->job = pagedJob;
+    addPage(engine, fetch, 0, 0, [&saved](PagedFetch &done) {
+      const FetchJob &first = done.job.first;
+      if (done.failed) {
+        // Saving part of the results would mark the rest as archived
+        std::cerr << "Not saving incomplete results for " << first.url
+                  << "\n";
+        return;
+      }
+      std::string html;
+      int pageCount = 0;
+      for (const auto &page : done.pages) {
+        if (!page.empty()) {
+          html += page;
+          ++pageCount;
+        }
+      }
+      if (html.empty()) {
+        std::cerr << "Download failed: " << first.url << "\n";
+        return;
+      }
+      if (!saveHtmlSnapshot(first.url, first.type, first.agent, html)
+               .empty()) {
+        std::cout << "Saved " << done.seenIds.size() << " results from "
+                  << pageCount << " page(s) of " << first.url << "\n";
+        ++saved;
+      }
+    });
+  }
+
+  engine.run();
+  store.save();
+  return saved;
+}
+
+std::string fetchAndSaveOne(const FetchJob &job) {
+  ValidatorStore store;
+  store.load();
+
+  std::string savedHash;
+  FetchEngine engine;
+  addSnapshotJob(engine, job, store,
+                 [&savedHash](const std::string &, const std::string &hash) {
+                   savedHash = hash;
+                 });
+  engine.run();
+  store.save();
+
+  std::string html;
+  if (!savedHash.empty()) {
+    loadBlob(snapshotDir(), savedHash, html);
+  }
+  return html;
+}
+
+} // namespace HT
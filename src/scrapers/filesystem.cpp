@@ -1,12 +1,20 @@
 #include <fstream>
 #include <format> 
 #include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include <scrapers/include/filesystem.hpp>
 #include <scrapers/include/house_model.hpp>
 #include <scrapers/include/jsonHelper.hpp>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace HT {
 namespace fs = std::filesystem;
 // Example function to gather and sort all .json files from a directory
@@ -24,6 +32,8 @@ std::vector<fs::path> gatherJsonFiles(const std::string &dir) {
   return result;
 }
 
+fs::path snapshotDir() { return "../src/raw_html"; }
+
 // Utility to get a string like "html_2025-04-03_14-00-00.json"
 // You might prefer a shorter or simpler format
 std::string makeTimestampedFilename() {
@@ -37,7 +47,7 @@ std::string makeTimestampedFilename() {
   // Format using std::format with chrono support (C++20)
   std::string timestamp = std::format("{:%Y-%m-%d_%H-%M-%S}", zt);
 
-  return "../src/raw_html/html_" + timestamp + ".json";
+  return (snapshotDir() / ("html_" + timestamp + ".json")).string();
 }
 
 std::vector<Property> getAllPropertiesFromJson() {
@@ -56,15 +66,106 @@ std::vector<Property> getAllPropertiesFromJson() {
   return allProperties;
 }
 
-int writeToPropertiesJsonFile(std::vector<Property> allProperties) {
-  nlohmann::json finalJson = HT::propertiesToJson(allProperties);
-  std::ofstream ofs("../src/storage/properties.json");
-  if (!ofs.is_open()) {
-    std::cerr << "Failed to open ../src/storage/properties.json for writing!\n";
+namespace {
+
+const std::string kPropertiesPath = "../src/storage/properties.json";
+
+// properties.json as it is written: a JSON array with one compact property
+// per line, handed to sink in pieces of about 64 KiB
+template <typename Sink>
+void serializeProperties(const std::vector<Property> &properties, Sink sink) {
+  std::string buffer = "[";
+  for (size_t i = 0; i < properties.size(); ++i) {
+    buffer += i == 0 ? "\n" : ",\n";
+    HT::appendPropertyJson(buffer, properties[i]);
+    if (buffer.size() >= (64 << 10)) {
+      sink(buffer);
+      buffer.clear();
+    }
+  }
+  buffer += "\n]\n";
+  sink(buffer);
+}
+
+// Whether the file at path holds exactly what serializeProperties would
+// write, compared piece by piece as the list is serialized
+bool fileMatches(const std::string &path,
+                 const std::vector<Property> &properties) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs.is_open()) {
+    return false;
+  }
+  bool same = true;
+  std::string onDisk;
+  serializeProperties(properties, [&](const std::string &piece) {
+    if (!same) {
+      return;
+    }
+    onDisk.resize(piece.size());
+    ifs.read(onDisk.data(), static_cast<std::streamsize>(piece.size()));
+    same = ifs.gcount() == static_cast<std::streamsize>(piece.size()) &&
+           onDisk == piece;
+  });
+  return same && ifs.peek() == std::ifstream::traits_type::eof();
+}
+
+// Flushes a file all the way to the disk and closes it
+bool syncAndClose(std::FILE *file) {
+  bool ok = std::fflush(file) == 0;
+#ifdef _WIN32
+  ok = ok && _commit(_fileno(file)) == 0;
+#else
+  ok = ok && fsync(fileno(file)) == 0;
+#endif
+  return std::fclose(file) == 0 && ok;
+}
+
+} // namespace
+
+// properties.json is replaced, never rewritten in place: the list goes to a
+// temporary file that is synced and then renamed over it, so a crash leaves
+// either the old list or the new one
+int writeToPropertiesJsonFile(const std::vector<Property> &allProperties) {
+  // Serializing and comparing is cheap next to writing
+  if (fileMatches(kPropertiesPath, allProperties)) {
+    std::cout << "properties.json is unchanged (" << allProperties.size()
+              << " properties)\n";
+    return 0;
+  }
+
+  const std::string tmpPath = kPropertiesPath + ".tmp";
+  std::FILE *file = std::fopen(tmpPath.c_str(), "wb");
+  if (!file) {
+    std::cerr << "Failed to open " << tmpPath << " for writing!\n";
     return 1;
   }
-  ofs << finalJson.dump(4);
-  ofs.close();
+  bool ok = true;
+  serializeProperties(allProperties, [&](const std::string &piece) {
+    ok = ok && std::fwrite(piece.data(), 1, piece.size(), file) == piece.size();
+  });
+  std::error_code ec;
+  if (!syncAndClose(file) || !ok) {
+    std::cerr << "Failed to write " << tmpPath << "\n";
+    fs::remove(tmpPath, ec);
+    return 1;
+  }
+
+  fs::rename(tmpPath, kPropertiesPath, ec);
+  if (ec) {
+    std::cerr << "Failed to replace " << kPropertiesPath << ": "
+              << ec.message() << "\n";
+    fs::remove(tmpPath, ec);
+    return 1;
+  }
+#ifndef _WIN32
+  // The rename itself is only durable once the directory is synced
+  const int dir = open(fs::path(kPropertiesPath).parent_path().c_str(),
+                       O_RDONLY);
+  if (dir >= 0) {
+    fsync(dir);
+    close(dir);
+  }
+#endif
 
   std::cout << "Wrote " << allProperties.size()
             << " total properties to properties.json\n";
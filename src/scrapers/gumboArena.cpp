@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <scrapers/include/gumboArena.hpp>
+#include <scrapers/include/hash.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
+#include <unordered_set>
+
+namespace HT {
+namespace {
+
+constexpr size_t kAlignment = alignof(std::max_align_t);
+
+void *arenaAllocate(void *userdata, size_t size) {
+  return static_cast<GumboArena *>(userdata)->allocate(size);
+}
+
+// Gumbo frees its growing buffers while it parses; the space comes back
+// with the rest of the document on reset
+void arenaDeallocate(void *, void *) {}
+
+thread_local GumboArena threadArena;
+thread_local int openLeases = 0;
+bool arenaEnabled = false;
+
+} // namespace
+
+GumboOptions GumboArena::options() {
+  GumboOptions options = kGumboDefaultOptions;
+  options.allocator = arenaAllocate;
+  options.deallocator = arenaDeallocate;
+  options.userdata = this;
+  return options;
+}
+
+void *GumboArena::allocate(size_t size) {
+  size = (std::max<size_t>(size, 1) + kAlignment - 1) & ~(kAlignment - 1);
+  if (current < chunks.size() && chunks[current].size - offset >= size) {
+    void *block = chunks[current].data.get() + offset;
+    offset += size;
+    used += size;
+    return block;
+  }
+
+  // The chunks after the current one are free; take the next if it fits,
+  // otherwise put a new one in front of it
+  size_t next = chunks.empty() ? 0 : current + 1;
+  if (next >= chunks.size() || chunks[next].size < size) {
+    Chunk chunk;
+    chunk.size = std::max(kChunkSize, size);
+    chunk.data = std::make_unique<std::byte[]>(chunk.size);
+    chunks.insert(chunks.begin() + next, std::move(chunk));
+  }
+  current = next;
+  offset = size;
+  used += size;
+  return chunks[current].data.get();
+}
+
+void GumboArena::reset() {
+  size_t kept = 0;
+  size_t keep = 0;
+  while (keep < chunks.size() && kept + chunks[keep].size <= kKeepBytes) {
+    kept += chunks[keep].size;
+    ++keep;
+  }
+  chunks.resize(keep);
+  current = 0;
+  offset = 0;
+  used = 0;
+}
+
+size_t GumboArena::bytesReserved() const {
+  size_t total = 0;
+  for (const auto &chunk : chunks) {
+    total += chunk.size;
+  }
+  return total;
+}
+
+ArenaLease::ArenaLease() {
+  if (openLeases++ == 0) {
+    threadArena.reset();
+  }
+}
+
+ArenaLease::~ArenaLease() { --openLeases; }
+
+GumboArena &ArenaLease::arena() const { return threadArena; }
+
+void setGumboArena(bool enabled) { arenaEnabled = enabled; }
+
+bool gumboArenaEnabled() { return arenaEnabled; }
+
+GumboDocument::GumboDocument(const std::string &html, bool inArena) {
+  if (!inArena) {
+    parsed = gumbo_parse(html.c_str());
+    return;
+  }
+  lease.emplace();
+  const GumboOptions options = lease->arena().options();
+  // Up to the first NUL, like gumbo_parse
+  parsed = gumbo_parse_with_options(&options, html.c_str(),
+                                    std::strlen(html.c_str()));
+}
+
+// An arena document skips gumbo_destroy_output: it would only walk the tree
+// handing every node to the no-op deallocator
+GumboDocument::~GumboDocument() {
+  if (parsed && !lease) {
+    gumbo_destroy_output(&kGumboDefaultOptions, parsed);
+  }
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+volatile size_t rootChildren = 0; // keeps the timed parses from being elided
+
+// Gumbo's malloc allocator, counting the bytes it has live at once. Each
+// block carries its size ahead of it so the deallocator can take it off.
+struct LiveBytes {
+  size_t live = 0;
+  size_t peak = 0;
+};
+
+void *countingAllocate(void *userdata, size_t size) {
+  auto *count = static_cast<LiveBytes *>(userdata);
+  auto *block = static_cast<std::byte *>(std::malloc(size + kAlignment));
+  if (!block) {
+    return nullptr;
+  }
+  std::memcpy(block, &size, sizeof(size));
+  count->live += size;
+  count->peak = std::max(count->peak, count->live);
+  return block + kAlignment;
+}
+
+void countingDeallocate(void *userdata, void *ptr) {
+  if (!ptr) {
+    return;
+  }
+  auto *block = static_cast<std::byte *>(ptr) - kAlignment;
+  size_t size = 0;
+  std::memcpy(&size, block, sizeof(size));
+  static_cast<LiveBytes *>(userdata)->live -= size;
+  std::free(block);
+}
+
+void hashTree(const GumboNode *node, Sha256 &hash) {
+  const int type = node->type;
+  hash.update(&type, sizeof(type));
+  switch (node->type) {
+  case GUMBO_NODE_DOCUMENT:
+  case GUMBO_NODE_ELEMENT: {
+    const GumboVector &children = node->type == GUMBO_NODE_DOCUMENT
+                                      ? node->v.document.children
+                                      : node->v.element.children;
+    if (node->type == GUMBO_NODE_ELEMENT) {
+      const int tag = node->v.element.tag;
+      hash.update(&tag, sizeof(tag));
+      const GumboVector &attributes = node->v.element.attributes;
+      for (unsigned int i = 0; i < attributes.length; ++i) {
+        const auto *attribute =
+            static_cast<const GumboAttribute *>(attributes.data[i]);
+        hash.update(attribute->name, std::strlen(attribute->name) + 1);
+        hash.update(attribute->value, std::strlen(attribute->value) + 1);
+      }
+    }
+    hash.update(&children.length, sizeof(children.length));
+    for (unsigned int i = 0; i < children.length; ++i) {
+      hashTree(static_cast<const GumboNode *>(children.data[i]), hash);
+    }
+    break;
+  }
+  default:
+    hash.update(node->v.text.text, std::strlen(node->v.text.text) + 1);
+    break;
+  }
+}
+
+std::string treeHash(const GumboOutput *output) {
+  Sha256 hash;
+  if (output) {
+    hashTree(output->document, hash);
+  }
+  return hash.hexDigest();
+}
+
+} // namespace
+
+int benchGumboArena(const std::string &rawHtmlDir) {
+  std::vector<std::string> pages;
+  std::unordered_set<std::string> seenHashes;
+  size_t totalBytes = 0;
+  for (const auto &record : archivedSnapshotRecords(rawHtmlDir)) {
+    if (record.unchanged || !seenHashes.insert(record.hash).second) {
+      continue;
+    }
+    std::string page;
+    if (loadSnapshotPage(rawHtmlDir, record, page) && !page.empty()) {
+      totalBytes += page.size();
+      pages.push_back(std::move(page));
+    }
+  }
+  if (pages.empty()) {
+    std::cerr << "No archived pages in " << rawHtmlDir << "\n";
+    return 1;
+  }
+
+  // The arena never takes back what Gumbo frees while it parses, so a page
+  // holds all it ever allocated there; malloc only holds what is live
+  size_t mismatches = 0;
+  size_t peakLive = 0;
+  size_t peakUsed = 0;
+  double worstRatio = 0;
+  for (const auto &page : pages) {
+    LiveBytes count;
+    GumboOptions options = kGumboDefaultOptions;
+    options.allocator = countingAllocate;
+    options.deallocator = countingDeallocate;
+    options.userdata = &count;
+    GumboOutput *output = gumbo_parse_with_options(
+        &options, page.c_str(), std::strlen(page.c_str()));
+    const std::string expected = treeHash(output);
+    gumbo_destroy_output(&options, output);
+
+    GumboDocument document(page, true);
+    if (treeHash(document.output()) != expected) {
+      ++mismatches;
+    }
+    const size_t used = threadArena.bytesUsed();
+    peakLive = std::max(peakLive, count.peak);
+    peakUsed = std::max(peakUsed, used);
+    if (count.peak > 0) {
+      worstRatio = std::max(worstRatio, static_cast<double>(used) /
+                                            static_cast<double>(count.peak));
+    }
+  }
+
+  // About 200 page parses each, at least one pass
+  const size_t rounds = std::max<size_t>(1, 200 / pages.size());
+  size_t children = 0;
+  auto start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r) {
+    for (const auto &page : pages) {
+      GumboOutput *output = gumbo_parse(page.c_str());
+      children += output->root->v.element.children.length;
+      gumbo_destroy_output(&kGumboDefaultOptions, output);
+    }
+  }
+  const double mallocSeconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r) {
+    for (const auto &page : pages) {
+      GumboDocument document(page, true);
+      children += document.root()->v.element.children.length;
+    }
+  }
+  const double arenaSeconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  rootChildren = children;
+
+  const double parses = static_cast<double>(rounds * pages.size());
+  const double mallocUs = mallocSeconds * 1e6 / parses;
+  const double arenaUs = arenaSeconds * 1e6 / parses;
+  char line[160];
+  std::cout << pages.size() << " distinct pages, " << totalBytes / 1024
+            << " KB\n";
+  std::snprintf(line, sizeof(line), "malloc: %.0f us per page\n", mallocUs);
+  std::cout << line;
+  std::snprintf(line, sizeof(line), "arena:  %.0f us per page (%.2fx)\n",
+                arenaUs, arenaUs > 0 ? mallocUs / arenaUs : 0.0);
+  std::cout << line;
+  std::snprintf(line, sizeof(line),
+                "malloc: largest page had %zu KB live at its peak\n",
+                peakLive / 1024);
+  std::cout << line;
+  std::snprintf(line, sizeof(line),
+                "arena:  largest page took %zu KB, %zu KB held, up to %.1fx "
+                "a page's malloc peak\n",
+                peakUsed / 1024, threadArena.bytesReserved() / 1024,
+                worstRatio);
+  std::cout << line;
+
+  if (mismatches != 0) {
+    std::cerr << mismatches << " pages parsed differently in the arena\n";
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace HT
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <scrapers/include/httpClient.hpp>
+
+namespace HT {
+
+HttpClient &HttpClient::instance() {
+  static HttpClient client;
+  return client;
+}
+
+HttpClient::HttpClient() {
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+
+  share = curl_share_init();
+  if (!share) {
+    std::cerr << "Failed to init curl share handle\n";
+    return;
+  }
+  curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockShared);
+  curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockShared);
+  curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+}
+
+HttpClient::~HttpClient() {
+  // Handles must go before the share they are attached to
+  for (CURL *easy : pool) {
+    curl_easy_cleanup(easy);
+  }
+  pool.clear();
+  if (share) {
+    curl_share_cleanup(share);
+  }
+  curl_global_cleanup();
+}
+
+void HttpClient::lockShared(CURL *, curl_lock_data data, curl_lock_access,
+                            void *userptr) {
+  static_cast<HttpClient *>(userptr)->shareLocks[data].lock();
+}
+
+void HttpClient::unlockShared(CURL *, curl_lock_data data, void *userptr) {
+  static_cast<HttpClient *>(userptr)->shareLocks[data].unlock();
+}
+
+CURL *HttpClient::acquire() {
+  CURL *easy = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (!pool.empty()) {
+      easy = pool.back();
+      pool.pop_back();
+    }
+  }
+
+  if (easy) {
+    // Drops the options of the previous transfer but keeps its caches
+    curl_easy_reset(easy);
+  } else {
+    easy = curl_easy_init();
+    if (!easy) {
+      std::cerr << "Failed to init curl\n";
+      return nullptr;
+    }
+  }
+
+  if (share) {
+    curl_easy_setopt(easy, CURLOPT_SHARE, share);
+  }
+  // "" offers every encoding this libcurl can decode (gzip, br, zstd)
+  curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, "");
+  curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+  // Wait for an HTTP/2 connection that is still being set up rather than
+  // opening a second one to the same host
+  curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+  return easy;
+}
+
+void HttpClient::release(CURL *easy, uint64_t decodedBytes) {
+  if (!easy) {
+    return;
+  }
+
+  long connects = 0;
+  curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &connects);
+  long httpVersion = 0;
+  curl_easy_getinfo(easy, CURLINFO_HTTP_VERSION, &httpVersion);
+  // SIZE_DOWNLOAD counts the body before content decoding
+  curl_off_t bodyBytes = 0;
+  curl_easy_getinfo(easy, CURLINFO_SIZE_DOWNLOAD_T, &bodyBytes);
+  long headerBytes = 0;
+  curl_easy_getinfo(easy, CURLINFO_HEADER_SIZE, &headerBytes);
+
+  std::lock_guard<std::mutex> lock(poolMutex);
+  ++counters.transfers;
+  counters.newConnections += connects;
+  if (connects == 0) {
+    ++counters.reusedConnections;
+  }
+  if (httpVersion == CURL_HTTP_VERSION_2_0) {
+    ++counters.http2Transfers;
+  }
+  counters.wireBytes += static_cast<uint64_t>(bodyBytes) +
+                        static_cast<uint64_t>(headerBytes);
+  counters.decodedBytes += decodedBytes;
+  pool.push_back(easy);
+}
+
+TransferStats HttpClient::stats() {
+  std::lock_guard<std::mutex> lock(poolMutex);
+  return counters;
+}
+
+void HttpClient::resetStats() {
+  std::lock_guard<std::mutex> lock(poolMutex);
+  counters = TransferStats{};
+}
+
+} // namespace HT
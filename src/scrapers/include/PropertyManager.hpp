@@ -1,16 +1,63 @@
 #include <filesystem>
+#include <scrapers/include/changeEvents.hpp>
+#include <scrapers/include/fetchEngine.hpp>
 #include <scrapers/include/house_model.hpp>
+#include <scrapers/include/ingestCheckpoint.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
 namespace HT {
 
+// Merges snapshots into a property list. Properties are found by id through
+// an index kept for as long as the merger lives, so a whole ingest pays for
+// building it once; the list must not be changed behind its back. What
+// changed is added to events, if given.
+class PropertyMerger {
+public:
+  explicit PropertyMerger(std::vector<Property> &properties,
+                          std::vector<ChangeEvent> *events = nullptr);
+
+  // Merges one snapshot's properties, moving the new ones in. source and
+  // timestamp are those of the snapshot, for the events.
+  void merge(std::vector<Property> &&newOnes, const std::string &source = "",
+             long long timestamp = 0);
+
+private:
+  void merge(Property &&newProp);
+  void record(ChangeKind kind, const std::string &id, long long oldValue,
+              long long newValue, std::string oldText = "",
+              std::string newText = "");
+
+  std::vector<Property> &properties;
+  std::vector<ChangeEvent> *events;
+  std::unordered_map<std::string, size_t> indexById;
+  const std::string *source = nullptr; // of the snapshot being merged
+  long long timestamp = 0;
+};
+
 class PropertyManager {
 public:
   static void traverseAllHtmlAndMergeProperties(
       std::vector<Property> &allProperties,
       std::vector<std::filesystem::path> htmlFiles);
 
+  // Parses only the snapshots saved after the checkpoint, merges them into
+  // allProperties and advances the checkpoint; statuses and dates of all
+  // properties are then set from the checkpoint's facts. What changed is
+  // added to events, if given; when everything is ingested again into
+  // properties loaded from disk, only a New event per property is.
+  static void ingestNewSnapshots(std::vector<Property> &allProperties,
+                                 const std::vector<SnapshotRecord> &records,
+                                 const std::filesystem::path &rawHtmlDir,
+                                 IngestCheckpoint &checkpoint,
+                                 std::vector<ChangeEvent> *events = nullptr);
+
   // Merges new properties into existing, tracking price changes
   static void mergeProperties(std::vector<Property> &existing,
                               const std::vector<Property> &newOnes);
+  static void mergeProperties(std::vector<Property> &existing,
+                              std::vector<Property> &&newOnes);
 
   static bool isSameProperty(const Property &a, const Property &b);
   static std::string propertyAgentToString(RealEstateAgent agent);
@@ -20,5 +67,18 @@ public:
   static PropertyType stringToPropertyType(const std::string &str);
   static std::string cleanId(const std::string &raw);
   static int runPropertyParsers(bool downloadNewHtml);
+  // reindex ignores the ingest checkpoint and parses every snapshot again,
+  // e.g. after a parser changed
+  static int runPropertyParsers(bool downloadNewHtml,
+                                const FetchOptions &fetchOptions,
+                                bool reindex = false);
 };
+
+// Runs the parser for the agent the snapshot's url belongs to
+std::vector<RawProperty> parseSnapshotHtml(const SnapshotRecord &record,
+                                           const std::string &rawHtml);
+
+// Every field of every property, one line per property, for checking two
+// ways of parsing a page against each other
+std::string describeRawProperties(const std::vector<RawProperty> &properties);
 } // namespace HT
@@ -0,0 +1,56 @@
+// blobStore.hpp
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <scrapers/include/hash.hpp>
+#include <string>
+
+namespace HT {
+
+// Page bodies are stored once per distinct content under
+// <rawHtmlDir>/blobs/<first two hex digits>/<sha256>.html; the
+// html_<timestamp>.json files in rawHtmlDir only reference them by hash.
+std::filesystem::path blobPathForHash(const std::filesystem::path &rawHtmlDir,
+                                      const std::string &hash);
+
+// Stores the body unless identical content is already present and
+// returns its hash ("" on failure)
+std::string storeBlob(const std::filesystem::path &rawHtmlDir,
+                      const std::string &body);
+
+// Writes a body into the blob store as it arrives: bytes go to a temp file
+// and into the hash, and commit() renames the file to its content address.
+// A writer that is never committed removes its temp file.
+class BlobWriter {
+public:
+  explicit BlobWriter(const std::filesystem::path &rawHtmlDir);
+  ~BlobWriter();
+
+  BlobWriter(const BlobWriter &) = delete;
+  BlobWriter &operator=(const BlobWriter &) = delete;
+
+  bool write(const char *data, size_t size);
+  // Returns the hash of everything written ("" on failure)
+  std::string commit();
+  void abort();
+
+  uint64_t size() const { return bytesWritten; }
+
+private:
+  std::filesystem::path rawHtmlDir;
+  std::filesystem::path tmpPath;
+  std::ofstream ofs;
+  Sha256 sha;
+  uint64_t bytesWritten = 0;
+  bool failed = false;
+};
+
+bool loadBlob(const std::filesystem::path &rawHtmlDir, const std::string &hash,
+              std::string &body);
+
+// Rewrites html_*.json files that still embed their page as
+// hash-referencing entries. Returns the number of files converted.
+int migrateLegacySnapshots(const std::string &rawHtmlDir);
+
+} // namespace HT
@@ -0,0 +1,77 @@
+// cardExtractor.hpp
+#pragma once
+#include <gumbo.h>
+#include <scrapers/include/house_model.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace HT {
+
+// How the class attribute of an element has to name a field
+enum class ClassMatch {
+  Whole,    // the attribute is exactly the name
+  Token,    // one of its whitespace-separated classes is the name
+  Substring // the name appears anywhere in it
+};
+
+// Where the value of a field is read from
+enum class FieldSource {
+  Text,       // the element's text
+  ParentText, // its parent's text, for a label next to an icon
+  Attribute   // one of its attributes
+};
+
+struct FieldSpec {
+  const char *className;
+  ClassMatch match;
+  FieldSource source;
+  std::string RawProperty::*field;
+  const char *attribute = nullptr; // for FieldSource::Attribute
+};
+
+// Where the card image is: the src of an <img> itself, or of the first
+// <img> below an element of another tag
+struct ImageSpec {
+  GumboTag tag = GUMBO_TAG_IMG;
+  const char *className = nullptr;     // whole class attribute, if required
+  const char *attribute = nullptr;     // attribute the element must have...
+  const char *value = nullptr;         // ...with this value
+  const char *srcContains = nullptr;   // only sources containing this
+  const char *prefix = "";             // prepended to the source
+  bool firstWins = false;              // otherwise the last one found wins
+};
+
+// What an agent's listing card holds. When several fields match an
+// element, the first one listed wins.
+struct CardSpec {
+  std::vector<FieldSpec> fields;
+  ImageSpec image;
+};
+
+// Fills a RawProperty from a card in one walk over it. The spec is compiled
+// once: whole and token matches become a lookup by class name, so an
+// element costs one table probe per class it has and nothing is allocated
+// but the field values.
+class CardExtractor {
+public:
+  explicit CardExtractor(CardSpec spec);
+
+  void extract(GumboNode *card, RawProperty &property) const;
+
+private:
+  void visit(GumboNode *node, RawProperty &property) const;
+  int matchField(const char *classAttr) const; // -1 if none
+  void readField(const FieldSpec &field, GumboNode *node,
+                 RawProperty &property) const;
+  void readImage(GumboNode *node, const char *classAttr,
+                 RawProperty &property) const;
+
+  CardSpec spec;
+  std::unordered_map<std::string_view, int> wholeIndex;
+  std::unordered_map<std::string_view, int> tokenIndex;
+  std::vector<int> substringFields; // in priority order
+};
+
+} // namespace HT
@@ -0,0 +1,63 @@
+// changeEvents.hpp
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace HT {
+
+enum class ChangeKind : uint8_t {
+  New,
+  PriceUp,
+  PriceDown,
+  OfferChange,
+  AgentChange,
+  CityChange,
+  Relisted,
+  Archived
+};
+
+std::string changeKindToString(ChangeKind kind);
+bool changeKindFromString(const std::string &str, ChangeKind &kind);
+
+// One thing ingest learned about a property, as of the snapshot that showed
+// it (for Archived: the last snapshot the property was seen in)
+struct ChangeEvent {
+  ChangeKind kind = ChangeKind::New;
+  long long timestamp = 0;
+  std::string source; // entry file the change was found in
+  std::string id;
+  long long oldValue = 0; // prices and offers
+  long long newValue = 0;
+  std::string oldText; // agent and city names
+  std::string newText;
+};
+
+// ../src/storage/events.bin is an append-only run of
+//   u32 size | payload | u32 size
+// payload: u8 kind | i64 timestamp | source | id | i64 old | i64 new |
+//          old text | new text
+// with little-endian numbers and strings as u32 size and bytes. The
+// trailing size lets the newest event be read from the end of the file.
+
+// Appends the events found in entries newer than the newest event in the
+// log, so ingesting the same snapshots again adds nothing. Returns the
+// number appended, -1 on failure.
+int appendChangeEvents(const std::vector<ChangeEvent> &events,
+                       const std::string &path = "../src/storage/events.bin");
+
+// Every event in the log, oldest first; a torn last one is skipped
+std::vector<ChangeEvent>
+readChangeEvents(const std::string &path = "../src/storage/events.bin");
+
+struct ChangeQuery {
+  std::string id;    // "" for every property
+  std::string kind;  // as printed, e.g. "price-down"; "" for every kind
+  std::string since; // YYYY-MM-DD, "" for all time
+};
+
+// Prints the matching events, one per line
+int printChangeEvents(const ChangeQuery &query,
+                      const std::string &path = "../src/storage/events.bin");
+
+} // namespace HT
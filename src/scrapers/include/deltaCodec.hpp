@@ -0,0 +1,24 @@
+// deltaCodec.hpp
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace HT {
+
+// Binary diff of one page against an earlier version of it: the target is
+// rebuilt from COPY (offset and length in the base) and ADD (literal
+// bytes) operations found with a rolling hash over 32-byte windows.
+//   varint target size | { 0 varint length bytes | 1 varint offset varint length }
+std::string encodeDelta(std::string_view base, std::string_view target);
+
+// Rebuilds the target into `target` (its capacity is reused); false if the
+// delta is malformed or does not fit the base
+bool applyDelta(std::string_view base, std::string_view delta,
+                std::string &target);
+
+// Delta-encodes every archived snapshot against the previous snapshot of
+// its url, with a full keyframe every keyframeInterval versions, and
+// prints the compression ratio and the encode and reconstruction speed
+int benchDeltaEncoding(const std::string &rawHtmlDir, int keyframeInterval);
+
+} // namespace HT
@@ -0,0 +1,147 @@
+// fetchEngine.hpp
+#pragma once
+#include <chrono>
+#include <curl/curl.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <scrapers/include/house_model.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace HT {
+
+// One page to download, tagged with what the scraper already knows about it
+struct FetchJob {
+  std::string url;
+  PropertyType type = PropertyType::Undefined;
+  RealEstateAgent agent = RealEstateAgent::Undefined;
+  std::vector<std::string> headers; // extra request headers, "Name: value"
+};
+
+struct FetchResult {
+  FetchJob job;
+  bool success = false;
+  long httpStatus = 0;
+  int attempts = 0;
+  std::string body;
+  std::string error;
+  std::string etag;         // response validators, empty if not sent
+  std::string lastModified;
+};
+
+// Limits on how many requests are in flight at the same time, and how
+// long a slow or broken site may hold up a run
+struct FetchOptions {
+  int maxInFlight = 24;        // across all hosts
+  int maxInFlightPerHost = 10; // per host, enough for a full Betri run
+
+  // Per request: time to connect, time for the whole transfer, and the
+  // slowest rate (bytes/s over lowSpeedSeconds) before it counts as stalled
+  long connectTimeoutMs = 10000;
+  long requestTimeoutMs = 60000;
+  long lowSpeedBytesPerSecond = 512;
+  long lowSpeedSeconds = 15;
+  // Connection errors, timeouts, 429 and 5xx are retried up to maxRetries
+  // times after retryBackoffMs * 2^n, +-50% jitter. A transfer that already
+  // handed part of its body on is not retried.
+  int maxRetries = 2;
+  long retryBackoffMs = 500;
+  // After this many failed attempts in a row a host gets no more requests
+  // for the rest of the run
+  int hostFailureLimit = 4;
+  // Whatever is still queued or running after this fails (0 = no limit)
+  long runDeadlineMs = 180000;
+
+  // When set (e.g. "http://127.0.0.1:8090"), pages are requested from a
+  // --replay-server instead of the live sites; snapshots still record the
+  // original url
+  std::string replayEndpoint;
+};
+
+using FetchCallback = std::function<void(FetchResult &result)>;
+// Receives the body chunk by chunk instead of FetchResult::body; returning
+// false aborts the transfer
+using DataCallback = std::function<bool(const char *data, size_t size)>;
+
+// Runs many downloads concurrently on a single curl multi handle.
+// Jobs may be added from inside a callback; run() returns once the queue
+// and all running transfers are drained, or the run deadline has passed.
+class FetchEngine {
+public:
+  explicit FetchEngine(FetchOptions options = {});
+  ~FetchEngine();
+
+  FetchEngine(const FetchEngine &) = delete;
+  FetchEngine &operator=(const FetchEngine &) = delete;
+
+  void add(FetchJob job, FetchCallback onDone, DataCallback onData = nullptr);
+  void run();
+
+private:
+  using Clock = std::chrono::steady_clock;
+  struct Transfer;
+
+  static size_t writeBody(char *data, size_t size, size_t nmemb,
+                          void *userp);
+  void startQueuedTransfers();
+  void finishTransfer(Transfer *transfer, CURLcode code);
+  bool scheduleRetry(std::unique_ptr<Transfer> &transfer, CURLcode code);
+  void startDueRetries();
+  void failEverything(const std::string &reason);
+  bool hostGivenUp(const std::string &host) const;
+
+  FetchOptions options;
+  CURLM *multi = nullptr;
+  std::deque<std::unique_ptr<Transfer>> queued;
+  std::unordered_map<Transfer *, std::unique_ptr<Transfer>> running;
+  std::unordered_map<std::string, int> inFlightByHost;
+
+  // Retry and failure bookkeeping
+  std::vector<std::pair<Clock::time_point, std::unique_ptr<Transfer>>>
+      retrying;
+  std::unordered_map<std::string, int> failuresInARowByHost;
+  Clock::time_point deadline = Clock::time_point::max();
+  std::mt19937 rng{std::random_device{}()};
+  int retries = 0;
+};
+
+// Connect timeout and low-speed abort for a handle that is not run by a
+// FetchEngine
+void applyFetchTimeouts(CURL *easy, const FetchOptions &options);
+
+std::string hostFromUrl(const std::string &url);
+// Where a replay server serves `url`: "https://www.skyn.fo/ognir?x=1" ->
+// "/www.skyn.fo/ognir?x=1"
+std::string replayPathForUrl(const std::string &url);
+
+// A query whose results are split over several pages. All pages are saved
+// together as one snapshot of `first.url`, so a listing on page 3 is not
+// mistaken for an archived one.
+struct PagedJob {
+  FetchJob first; // the first page
+  // Url of the page that starts after `offset` results
+  std::function<std::string(size_t offset)> pageUrl;
+  // Result ids on a page; paging stops when a page brings no new ones
+  std::function<std::vector<std::string>(const std::string &html)> itemIds;
+  // A query still bringing new results on its last allowed page is treated
+  // as failed and not saved
+  int maxPages = 20;
+};
+
+// Downloads every job concurrently and saves each finished page as a
+// raw_html snapshot. Bodies are unwrapped and written to the blob store as
+// they arrive, so no page is ever held in memory whole. Pages are requested
+// conditionally; a 304 records an "unchanged" marker instead of a new copy
+// of the page. Paged jobs are always fetched in full. Returns the number of
+// snapshots and markers written.
+int fetchAndSaveAll(const std::vector<FetchJob> &jobs,
+                    const FetchOptions &options = {},
+                    const std::vector<PagedJob> &pagedJobs = {});
+// Same for a single page; returns its HTML, or "" when the download failed
+// or the page was unchanged
+std::string fetchAndSaveOne(const FetchJob &job);
+
+} // namespace HT
@@ -8,7 +8,9 @@
 namespace HT {
 namespace fs = std::filesystem;
 std::vector<fs::path> gatherJsonFiles(const std::string &dir);
+// Where downloaded snapshots are saved, entries and blobs alike
+fs::path snapshotDir();
 std::string makeTimestampedFilename();
 std::vector<Property> getAllPropertiesFromJson();
-int writeToPropertiesJsonFile(std::vector<Property> allProperties);
+int writeToPropertiesJsonFile(const std::vector<Property> &allProperties);
 } // namespace HT
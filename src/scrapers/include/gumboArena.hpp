@@ -0,0 +1,89 @@
+// gumboArena.hpp
+#pragma once
+#include <cstddef>
+#include <gumbo.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace HT {
+
+// Bump allocator behind Gumbo's allocator hooks. A parse takes its nodes,
+// attributes and text buffers from a few large chunks and nothing is freed
+// one by one: reset() drops the whole document at once and keeps the chunks
+// for the next one.
+class GumboArena {
+public:
+  static constexpr size_t kChunkSize = 1 << 20;
+  // Chunks beyond this are released on reset, so one huge page does not
+  // keep its memory for the rest of the run
+  static constexpr size_t kKeepBytes = 16 * kChunkSize;
+
+  GumboArena() = default;
+  GumboArena(const GumboArena &) = delete;
+  GumboArena &operator=(const GumboArena &) = delete;
+
+  // Options for gumbo_parse_with_options that allocate from this arena
+  GumboOptions options();
+
+  void *allocate(size_t size);
+  void reset();
+
+  size_t bytesUsed() const { return used; } // since the last reset
+  size_t bytesReserved() const;
+
+private:
+  struct Chunk {
+    std::unique_ptr<std::byte[]> data;
+    size_t size = 0;
+  };
+
+  std::vector<Chunk> chunks;
+  size_t current = 0; // chunk being filled
+  size_t offset = 0;  // first free byte in it
+  size_t used = 0;
+};
+
+// Holds the calling thread's arena open. Opening one while no other is open
+// on the thread resets the arena, so a parse worker reuses the same chunks
+// for every snapshot it handles.
+class ArenaLease {
+public:
+  ArenaLease();
+  ~ArenaLease();
+  ArenaLease(const ArenaLease &) = delete;
+  ArenaLease &operator=(const ArenaLease &) = delete;
+
+  GumboArena &arena() const;
+};
+
+// Whether GumboDocument parses into the arena. Off by default: Gumbo keeps
+// its own malloc allocator until the arena has been measured against it on
+// the real library. Set before any parse worker starts.
+void setGumboArena(bool enabled);
+bool gumboArenaEnabled();
+
+// A page parsed by Gumbo, into the calling thread's arena when inArena is set
+class GumboDocument {
+public:
+  explicit GumboDocument(const std::string &html,
+                         bool inArena = gumboArenaEnabled());
+  ~GumboDocument();
+  GumboDocument(const GumboDocument &) = delete;
+  GumboDocument &operator=(const GumboDocument &) = delete;
+
+  GumboOutput *output() const { return parsed; } // nullptr if parsing failed
+  GumboNode *root() const { return parsed ? parsed->root : nullptr; }
+
+private:
+  std::optional<ArenaLease> lease;
+  GumboOutput *parsed = nullptr;
+};
+
+// Parses every distinct archived page with Gumbo's malloc allocator and with
+// the arena, checks both give the same tree and prints the time per page and
+// the most memory a page held each way
+int benchGumboArena(const std::string &rawHtmlDir);
+
+} // namespace HT
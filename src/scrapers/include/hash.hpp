@@ -0,0 +1,30 @@
+// hash.hpp
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace HT {
+
+// Incremental SHA-256, used to address stored page bodies by content
+class Sha256 {
+public:
+  Sha256();
+  void update(const void *data, size_t size);
+  void update(std::string_view data) { update(data.data(), data.size()); }
+  // Lowercase hex digest; the object must not be updated afterwards
+  std::string hexDigest();
+
+private:
+  void processBlock(const uint8_t *block);
+
+  std::array<uint32_t, 8> state;
+  std::array<uint8_t, 64> buffer;
+  size_t bufferSize = 0;
+  uint64_t totalBytes = 0;
+};
+
+std::string sha256Hex(std::string_view data);
+
+} // namespace HT
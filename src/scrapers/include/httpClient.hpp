@@ -0,0 +1,56 @@
+// httpClient.hpp
+#pragma once
+#include <cstdint>
+#include <curl/curl.h>
+#include <mutex>
+#include <vector>
+
+namespace HT {
+
+struct TransferStats {
+  long transfers = 0;
+  long newConnections = 0;
+  long reusedConnections = 0; // transfers that needed no new connection
+  long http2Transfers = 0;
+  uint64_t wireBytes = 0;    // headers plus body as received, compressed
+  uint64_t decodedBytes = 0; // body after content decoding
+};
+
+// Process-wide download client. Easy handles are pooled and all of them
+// share one DNS cache, connection cache and TLS session cache, so repeated
+// requests to the same hosts skip the lookup and handshakes. Every handle
+// asks for compressed bodies and HTTP/2, so concurrent requests to one host
+// are multiplexed over a single connection.
+class HttpClient {
+public:
+  static HttpClient &instance();
+
+  HttpClient(const HttpClient &) = delete;
+  HttpClient &operator=(const HttpClient &) = delete;
+
+  // Returns a reset handle attached to the shared caches
+  CURL *acquire();
+  // Records the finished transfer (connection reuse, bytes received, and
+  // the bytes the caller got after decoding) and pools the handle
+  void release(CURL *easy, uint64_t decodedBytes);
+
+  TransferStats stats();
+  void resetStats();
+
+private:
+  HttpClient();
+  ~HttpClient();
+
+  static void lockShared(CURL *handle, curl_lock_data data,
+                         curl_lock_access access, void *userptr);
+  static void unlockShared(CURL *handle, curl_lock_data data, void *userptr);
+
+  CURLSH *share = nullptr;
+  std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+
+  std::mutex poolMutex;
+  std::vector<CURL *> pool;
+  TransferStats counters;
+};
+
+} // namespace HT
@@ -0,0 +1,33 @@
+// ingestCheckpoint.hpp
+#pragma once
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace HT {
+
+// What ingest has learned from the raw_html entries up to lastFile. It is
+// saved next to properties.json, so the next run only has to parse the
+// entries saved since.
+struct IngestCheckpoint {
+  struct UrlState {
+    std::string latestFile; // newest entry with listings
+    long long latestTimestamp = 0;
+    long long lastConfirmed = 0;  // newest fetch, counting 304 markers
+    std::vector<std::string> ids; // listings in latestFile
+  };
+
+  std::string lastFile;     // newest entry file ingested
+  size_t ingestedCount = 0; // entry files up to and including lastFile
+  std::unordered_map<std::string, long long> firstSeenById;
+  std::unordered_map<std::string, long long> lastSeenById;
+  std::unordered_map<std::string, UrlState> byUrl;
+
+  bool load(const std::string &path = "../src/storage/ingest_checkpoint.json");
+  bool save(
+      const std::string &path = "../src/storage/ingest_checkpoint.json") const;
+  void clear();
+};
+
+} // namespace HT
@@ -17,6 +17,10 @@ bool isSameProperty(const Property &a, const Property &b);
 // Convert entire property list to JSON array
 nlohmann::json propertiesToJson(const std::vector<Property> &props);
 
+// Append a single Property to out as compact JSON, byte for byte what
+// propertyToJson(prop).dump() gives, without building the json value
+void appendPropertyJson(std::string &out, const Property &prop);
+
 // Convert JSON array to entire property list
 std::vector<Property> jsonToProperties(const nlohmann::json &arr);
 
@@ -0,0 +1,45 @@
+// parseCache.hpp
+#pragma once
+#include <cstdint>
+#include <scrapers/include/house_model.hpp>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace HT {
+
+// What the agent parsers found in each distinct page, so a reindex only
+// runs Gumbo for pages it has not seen or whose parser has changed since.
+// ../src/storage/parse_cache.bin is a run of records
+//   "HTPC" | u32 key size | u32 value size | key | value
+// (little-endian) where the key is "<hash>|<type>|<agent>|<parser version>"
+// and the value is the RawProperty list, every string stored as u32 size
+// and bytes. A later record for the same key wins.
+class ParseCache {
+public:
+  explicit ParseCache(std::string path = "../src/storage/parse_cache.bin");
+
+  // Loads the records on disk, ignoring a torn last one
+  bool load();
+  bool find(const std::string &key, std::vector<RawProperty> &properties);
+  void add(const std::string &key, const std::vector<RawProperty> &properties);
+  // Appends the records added since load. With dropUnused the file is
+  // rewritten with only the records found or added during this run, which
+  // after a full reindex sheds the results of old parser versions.
+  bool save(bool dropUnused = false);
+
+  size_t hits() const { return hitCount; }
+
+private:
+  std::string path;
+  std::string data;      // records read by load, then the ones added
+  uint64_t savedEnd = 0; // bytes of data that are whole records on disk
+  // key -> start and size of its value in data
+  std::unordered_map<std::string, std::pair<uint64_t, uint64_t>> index;
+  std::unordered_set<std::string> used;
+  size_t hitCount = 0;
+};
+
+} // namespace HT
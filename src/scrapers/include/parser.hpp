@@ -5,6 +5,7 @@
 
 namespace HT {
 
+void appendNodeText(GumboNode *node, std::string &out);
 std::string getNodeText(GumboNode *node);
 const char *getClassAttr(GumboNode *node);
 const char *getAttribute(const GumboVector *attrs, const char *name);
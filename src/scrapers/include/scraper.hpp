@@ -1,6 +1,7 @@
 // scraper.hpp
 #pragma once
 
+#include <scrapers/include/fetchEngine.hpp>
 #include <scrapers/include/house_model.hpp>
 #include <string>
 
@@ -13,7 +14,23 @@ std::string downloadAndSaveHtml(const std::string &url, PropertyType propType);
 std::string downloadAndSaveHtml(const std::string &url, PropertyType propType,
                                 RealEstateAgent agent);
 
-void checkAndDownloadImages(const std::vector<Property> &allProperties);
+// Stores one downloaded page in the blob store and records the fetch in a
+// new timestamped raw_html entry; returns the entry path ("" on failure)
+std::string saveHtmlSnapshot(const std::string &url, PropertyType propType,
+                             RealEstateAgent agent, const std::string &html);
+// Records a fetch whose body is already in the blob store under `hash`
+std::string saveSnapshotEntry(const std::string &url, PropertyType propType,
+                              RealEstateAgent agent, const std::string &hash);
+// Records that a page was unchanged (HTTP 304) at the current time
+std::string saveUnchangedMarker(const std::string &url, PropertyType propType,
+                                RealEstateAgent agent);
+// Unwraps {"html": "..."} API payloads; plain HTML is returned unchanged
+std::string extractHtmlFromJson(const std::string &payload);
+
+// Downloads the images of all properties that are not in raw_images yet,
+// concurrently and each through a temp file
+void checkAndDownloadImages(const std::vector<Property> &allProperties,
+                            const FetchOptions &options = {});
 std::string getFilenameFromUrl(const std::string &url);
 std::string cleanAsciiFilename(const std::string &filename);
 } // namespace HT
@@ -0,0 +1,88 @@
+// segmentLog.hpp
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <scrapers/include/snapshotManifest.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace HT {
+
+// Archived snapshots packed into a few large append-only files,
+// ../src/raw_html/segments/segment-<n>.htseg. Every record is
+//   "HTSR" | u32 metadata size | u64 body size | metadata JSON | body
+// with little-endian sizes. A body is stored once per log: later records
+// with the same hash have no body and point at the record holding it. A
+// new page of a url the log has seen is usually stored as a delta against
+// the previous version (see deltaCodec.hpp), with a full keyframe every
+// keyframeInterval versions and after the log is reopened.
+// A finished segment ends in an index footer
+//   u64 record offset... | u64 record count | u64 index start | "HTSINDEX"
+// so its records are found without a scan. A segment without a footer
+// (still open, or cut short by a crash) is read by walking the records.
+class SegmentLog {
+public:
+  explicit SegmentLog(std::string dir = "../src/raw_html/segments",
+                      uint64_t segmentBytes = 64ull << 20,
+                      int keyframeInterval = 16);
+  ~SegmentLog(); // seals the open segment
+
+  SegmentLog(const SegmentLog &) = delete;
+  SegmentLog &operator=(const SegmentLog &) = delete;
+
+  bool contains(const std::string &file) const;
+  // Appends one snapshot; body is ignored for 304 markers and for bodies
+  // the log already holds
+  bool append(const SnapshotRecord &record, std::string_view body);
+  // Writes the index footer of the open segment
+  bool seal();
+
+private:
+  void load();
+  bool openSegment();
+
+  // Latest page appended for a url, the base of its next delta
+  struct UrlTip {
+    std::string segment;
+    uint64_t offset = 0;
+    int depth = 0; // deltas since the keyframe
+    std::string page;
+  };
+
+  std::string dir;
+  uint64_t segmentBytes;
+  int keyframeInterval;
+  std::unordered_set<std::string> files; // entry files in the log
+  std::unordered_map<std::string, SnapshotRecord> bodyByHash;
+  std::unordered_map<std::string, UrlTip> tipByUrl;
+
+  std::string reopenPath;  // last segment, if it still has room
+  std::string segmentPath; // open segment, empty when none
+  std::ofstream ofs;
+  uint64_t segmentSize = 0;
+  std::vector<uint64_t> offsets;
+  int nextSegment = 1;
+};
+
+// Every record in the log, in append order. segment/offset point at the
+// record that holds the body.
+std::vector<SnapshotRecord>
+readSegmentRecords(const std::string &dir = "../src/raw_html/segments");
+
+// Reads the record at offset of a segment; body may be null
+bool readSegmentRecord(const std::string &segment, uint64_t offset,
+                       SnapshotRecord &record, std::string *body);
+
+// Moves the html_*.json entries (and blobs only they use) into the log.
+// The newest entry with a page is kept for every url, since HTTP
+// validators and the replay server refer to it. Returns the number moved.
+int importSnapshotsToSegments(const std::string &rawHtmlDir);
+
+// Writes every record of the log back out as an html_*.json entry under
+// its original name, with its body in the blob store
+int exportSegmentsToSnapshots(const std::string &rawHtmlDir);
+
+} // namespace HT
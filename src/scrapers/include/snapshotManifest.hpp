@@ -0,0 +1,59 @@
+// snapshotManifest.hpp
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace HT {
+
+// What ingest needs to know about one html_<timestamp>.json entry, so the
+// entry files do not have to be opened and parsed on every run.
+struct SnapshotRecord {
+  std::string file; // entry file name inside raw_html
+  std::string url;
+  std::string type;
+  std::string agent;
+  long long timestamp = 0;
+  uint64_t size = 0;       // page bytes, 0 for 304 markers
+  std::string hash;        // page hash, empty for 304 markers
+  bool unchanged = false;  // 304 marker
+  bool inlineHtml = false; // legacy entry that embeds its page
+  // Snapshots archived in the segment log: the record holding the page
+  std::string segment;
+  uint64_t offset = 0;
+};
+
+// <rawHtmlDir>/manifest.jsonl holds one record per line and is appended to
+// whenever an entry is saved in rawHtmlDir
+bool appendManifestRecord(const std::filesystem::path &rawHtmlDir,
+                          const SnapshotRecord &record);
+
+// Reads one entry file into a record ("" url when it is not an entry)
+bool readSnapshotRecord(const std::filesystem::path &entryFile,
+                        SnapshotRecord &record);
+
+// Records for the given entry files of rawHtmlDir, in the same order. Files
+// the manifest does not know yet (copied in, or saved by an older build) are
+// read once and appended; files that are gone are simply not asked for.
+std::vector<SnapshotRecord>
+snapshotRecordsFor(const std::filesystem::path &rawHtmlDir,
+                   const std::vector<std::filesystem::path> &entryFiles);
+
+// All snapshots, from the html_*.json entries and the segment log, sorted
+// by entry name (that is, by time). An entry on disk wins over a segment
+// record of the same name.
+std::vector<SnapshotRecord>
+archivedSnapshotRecords(const std::string &rawHtmlDir);
+
+// The page of a snapshot, wherever it is kept: the blob store, the entry
+// itself (entries older than the blob store embed it) or the segment log.
+// html is reused between calls.
+bool loadSnapshotPage(const std::filesystem::path &rawHtmlDir,
+                      const SnapshotRecord &record, std::string &html);
+
+// Rewrites the manifest from the entry files on disk and returns the
+// number of records written (-1 on failure)
+int rebuildManifest(const std::string &rawHtmlDir);
+
+} // namespace HT
@@ -0,0 +1,56 @@
+// snapshotReader.hpp
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <scrapers/include/snapshotStream.hpp>
+#include <string>
+
+namespace HT {
+
+// Read-only view of a whole file mapped into memory
+class MappedFile {
+public:
+  explicit MappedFile(const std::filesystem::path &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool isOpen() const { return open; }
+  const char *data() const { return mapped; }
+  size_t size() const { return length; }
+
+private:
+  const char *mapped = nullptr;
+  size_t length = 0;
+  bool open = false;
+#ifdef _WIN32
+  void *fileHandle = nullptr;
+  void *mappingHandle = nullptr;
+#endif
+};
+
+// The top-level fields of an html_<timestamp>.json entry
+struct SnapshotFields {
+  std::string url;
+  std::string type;
+  std::string agent;
+  std::string hash; // set by entries that reference a blob
+  long long timestamp = 0;
+  bool unchanged = false;
+  bool hasHtml = false; // the entry embeds its page
+};
+
+// Reads an entry in a single pass over the mapped file, without building a
+// JSON document: an embedded page is unescaped straight into htmlSink
+// (which may be empty to skip it) and only the small remainder is parsed.
+bool readSnapshotFile(const std::filesystem::path &path,
+                      SnapshotFields &fields,
+                      const HtmlPayloadExtractor::Sink &htmlSink);
+
+// Same, with the page unescaped into html; its capacity is reused, so one
+// buffer can serve any number of files
+bool readSnapshotFile(const std::filesystem::path &path,
+                      SnapshotFields &fields, std::string &html);
+
+} // namespace HT
@@ -0,0 +1,80 @@
+// snapshotStream.hpp
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <scrapers/include/blobStore.hpp>
+#include <string>
+
+namespace HT {
+
+// Unwraps {"html": "..."} API payloads while they are still arriving.
+// The unescaped html value is passed on chunk by chunk; everything else in
+// the payload is small and kept in metadata() with the html value blanked
+// out. Bodies that are not a JSON object, or a JSON payload without an
+// "html" string, are passed on unchanged, like extractHtmlFromJson did.
+class HtmlPayloadExtractor {
+public:
+  using Sink = std::function<bool(const char *data, size_t size)>;
+
+  explicit HtmlPayloadExtractor(Sink sink);
+
+  bool feed(const char *data, size_t size);
+  // Call once the whole body was fed; returns false on a broken payload
+  bool finish();
+
+  bool isJsonPayload() const {
+    return mode == Mode::Json || mode == Mode::HtmlValue;
+  }
+  bool hasHtml() const { return htmlFound; }
+  const std::string &metadata() const { return outside; }
+
+private:
+  enum class Mode { Detect, Passthrough, Json, HtmlValue };
+
+  void feedJson(char c);
+  bool feedHtmlValue(char c, std::string &out);
+
+  Sink sink;
+  Mode mode = Mode::Detect;
+  std::string outside; // the payload minus the html value
+
+  // Where the JSON scanner is in the top-level object
+  int depth = 0;
+  bool inString = false;
+  bool stringEscape = false;
+  bool readingKey = false;
+  bool expectKey = false;
+  bool expectValue = false;
+  bool htmlFound = false;
+  std::string key;
+
+  // Escape sequence inside the html value that may span chunks
+  enum class Escape { None, Backslash, Unicode };
+  Escape escape = Escape::None;
+  std::string hexDigits;
+  uint32_t highSurrogate = 0;
+};
+
+// One download on its way into the blob store: feeds the payload through
+// an HtmlPayloadExtractor into a BlobWriter, so a page never has to be held
+// in memory as a whole.
+class SnapshotStream {
+public:
+  // The page goes to the blob store of rawHtmlDir
+  explicit SnapshotStream(const std::filesystem::path &rawHtmlDir);
+
+  bool write(const char *data, size_t size);
+  // Stores the page and returns its hash ("" when nothing usable arrived)
+  std::string commit();
+  void abort();
+
+  uint64_t htmlSize() const { return blob.size(); }
+  const HtmlPayloadExtractor &payload() const { return extractor; }
+
+private:
+  BlobWriter blob;
+  HtmlPayloadExtractor extractor;
+};
+
+} // namespace HT
@@ -0,0 +1,47 @@
+// tagScanner.hpp
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <gumbo.h>
+#include <string>
+
+// A forward-only alternative to parsing a whole page with Gumbo, for pages
+// where only a few elements matter. The scanner tokenizes the page the way
+// Gumbo does, but outside the elements it is asked for it only keeps track
+// of which elements are open.
+namespace HT {
+
+// Calls found with every element whose class attribute satisfies isRoot,
+// once the element is closed. The element and everything inside it are
+// built as Gumbo nodes in the calling thread's arena, so found can walk them
+// like a subtree of a Gumbo parse, except that the root has no parent. The
+// nodes are only valid until found returns. Roots inside a root are not
+// looked for.
+//
+// Returns false when the page holds something the scanner cannot place
+// exactly where Gumbo's tree construction would: misnested or implicitly
+// closed elements around or inside a root, tables, forms, scripts, character
+// references it does not know, invalid UTF-8 and the like. The caller then
+// drops what found produced and parses the page with Gumbo instead.
+bool scanElements(const std::string &html,
+                  bool (*isRoot)(const char *classAttr),
+                  const std::function<void(GumboNode *root)> &found);
+
+// Whether the Betri and Skyn parsers try the scanner before Gumbo. Off by
+// default until --verify-scanner has passed against the real Gumbo on real
+// pages of both agents. Set before any parse worker starts.
+void setTagScanner(bool enabled);
+bool tagScannerEnabled();
+
+// Runs the Betri and Skyn parsers with the scanner and with Gumbo on every
+// distinct archived page, checks they find the same properties and prints
+// the time per page. Then parses count copies of those pages, each with a
+// few random edits near the elements the parsers look for, both ways, and
+// checks the scanner either gives up or builds the same elements as Gumbo.
+// With dumpDir set, every edited page the scanner read is written there
+// with the elements it built, for tools/scannerOracle.py to check against
+// html5lib.
+int verifyTagScanner(const std::string &rawHtmlDir, size_t count,
+                     unsigned seed, const std::string &dumpDir);
+
+} // namespace HT
@@ -0,0 +1,48 @@
+// textScan.hpp
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Hand-written scanners for the text clean-up ingest does on every
+// property. Each one gives the same result as the std::regex it replaced,
+// quoted next to it, where "whitespace" is what \s matches: space, \t, \n,
+// \v, \f and \r.
+namespace HT {
+
+// std::regex_replace(s, std::regex("\\s+"), " ")
+std::string collapseWhitespace(std::string_view s);
+
+// std::regex_match(s, m, std::regex(R"(^(.*)\s+(\d{3})\s+(.+)$)")), for
+// "<street> <3-digit post> <city>". The views point into s.
+bool splitPostCode(std::string_view s, std::string_view &street,
+                   std::string_view &postNum, std::string_view &city);
+
+// std::regex_match(s, m, std::regex(R"(^(\d{3})\s+(.+)$)")), for
+// "<3-digit post> <city>"
+bool splitLeadingPostCode(std::string_view s, std::string_view &postNum,
+                          std::string_view &city);
+
+// The first match of std::regex(R"(\d[\d\.,]*)"), e.g. "1.001" in
+// "Grund stødd 1.001 m2"; empty if s has no digit
+std::string_view firstNumber(std::string_view s);
+
+// std::regex_search(s, std::regex("(^|\\s)" + word + "(\\s|$)")): word is
+// one of the whitespace-separated words of s
+bool hasWord(std::string_view s, std::string_view word);
+
+// std::regex_replace with a literal pattern
+std::string replaceAll(std::string_view s, std::string_view from,
+                       std::string_view to);
+
+// Times each scanner against its regex on the addresses, cities and sizes
+// the parsers find in every archived page, checks they agree and prints the
+// time per call
+int benchTextScan(const std::string &rawHtmlDir);
+
+// Checks every scanner against its regex on count random strings built
+// from whitespace, digits, dots, commas, quotes and the word hasWord is
+// asked for; prints the mismatches per scanner, 1 if there were any
+int verifyTextScan(size_t count, unsigned seed);
+
+} // namespace HT
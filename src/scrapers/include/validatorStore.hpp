@@ -0,0 +1,34 @@
+// validatorStore.hpp
+#pragma once
+#include <string>
+#include <unordered_map>
+
+namespace HT {
+
+// HTTP cache validators from the last full download of a URL
+struct Validators {
+  std::string etag;
+  std::string lastModified;
+  std::string snapshot; // raw_html file holding the body they describe
+};
+
+// Per-URL validators persisted between runs, used to send conditional GETs
+class ValidatorStore {
+public:
+  explicit ValidatorStore(
+      std::string path = "../src/storage/validators.json");
+
+  bool load();
+  bool save() const;
+
+  // Only returns validators whose snapshot is still on disk, so a 304 can
+  // never point at a body we no longer have
+  const Validators *find(const std::string &url) const;
+  void update(const std::string &url, Validators validators);
+
+private:
+  std::string path;
+  std::unordered_map<std::string, Validators> byUrl;
+};
+
+} // namespace HT
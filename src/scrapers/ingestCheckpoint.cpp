@@ -0,0 +1,100 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <scrapers/include/ingestCheckpoint.hpp>
+
+namespace HT {
+
+// Bumped whenever the stored facts change meaning; an older checkpoint is
+// then ignored and ingest starts over
+static const int kCheckpointVersion = 1;
+
+bool IngestCheckpoint::load(const std::string &path) {
+  clear();
+  std::ifstream ifs(path);
+  if (!ifs.is_open()) {
+    return false; // first run, nothing stored yet
+  }
+
+  try {
+    nlohmann::json j;
+    ifs >> j;
+    if (j.value("version", 0) != kCheckpointVersion) {
+      return false;
+    }
+    lastFile = j.value("lastFile", "");
+    ingestedCount = j.value("ingestedCount", size_t{0});
+    for (auto &[id, timestamp] : j.at("firstSeen").items()) {
+      firstSeenById[id] = timestamp.get<long long>();
+    }
+    for (auto &[id, timestamp] : j.at("lastSeen").items()) {
+      lastSeenById[id] = timestamp.get<long long>();
+    }
+    for (auto &[url, entry] : j.at("urls").items()) {
+      UrlState state;
+      state.latestFile = entry.value("latestFile", "");
+      state.latestTimestamp = entry.value("latestTimestamp", 0LL);
+      state.lastConfirmed = entry.value("lastConfirmed", 0LL);
+      state.ids = entry.value("ids", std::vector<std::string>{});
+      byUrl[url] = std::move(state);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Ignoring unreadable " << path << ": " << e.what() << "\n";
+    clear();
+    return false;
+  }
+  return true;
+}
+
+bool IngestCheckpoint::save(const std::string &path) const {
+  nlohmann::json j;
+  j["version"] = kCheckpointVersion;
+  j["lastFile"] = lastFile;
+  j["ingestedCount"] = ingestedCount;
+  j["firstSeen"] = firstSeenById;
+  j["lastSeen"] = lastSeenById;
+  nlohmann::json urls = nlohmann::json::object();
+  for (const auto &[url, state] : byUrl) {
+    urls[url] = {{"latestFile", state.latestFile},
+                 {"latestTimestamp", state.latestTimestamp},
+                 {"lastConfirmed", state.lastConfirmed},
+                 {"ids", state.ids}};
+  }
+  j["urls"] = std::move(urls);
+
+  // Written aside and renamed, so a crash never leaves half a checkpoint
+  const std::string tmpPath = path + ".tmp";
+  std::error_code ec;
+  {
+    std::ofstream ofs(tmpPath);
+    if (!ofs.is_open()) {
+      std::cerr << "Failed to open " << tmpPath << " for writing!\n";
+      return false;
+    }
+    ofs << j.dump(1);
+    ofs.close();
+    if (!ofs) {
+      std::cerr << "Failed to write " << tmpPath << "\n";
+      std::filesystem::remove(tmpPath, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(tmpPath, path, ec);
+  if (ec) {
+    std::cerr << "Error renaming " << tmpPath << ": " << ec.message() << "\n";
+    std::filesystem::remove(tmpPath, ec);
+    return false;
+  }
+  return true;
+}
+
+void IngestCheckpoint::clear() {
+  lastFile.clear();
+  ingestedCount = 0;
+  firstSeenById.clear();
+  lastSeenById.clear();
+  byUrl.clear();
+}
+
+} // namespace HT
@@ -100,6 +100,152 @@ nlohmann::json propertiesToJson(const std::vector<Property> &props) {
   return arr;
 }
 
+namespace {
+
+// Length of the well-formed UTF-8 sequence at s[i], 0 if it is not one
+size_t utf8SequenceLength(const std::string &s, size_t i) {
+  const unsigned char c = static_cast<unsigned char>(s[i]);
+  size_t length = 0;
+  unsigned char min = 0x80;
+  unsigned char max = 0xBF;
+  if (c >= 0xC2 && c <= 0xDF) {
+    length = 2;
+  } else if (c >= 0xE0 && c <= 0xEF) {
+    length = 3;
+    if (c == 0xE0)
+      min = 0xA0; // overlong
+    if (c == 0xED)
+      max = 0x9F; // surrogates
+  } else if (c >= 0xF0 && c <= 0xF4) {
+    length = 4;
+    if (c == 0xF0)
+      min = 0x90; // overlong
+    if (c == 0xF4)
+      max = 0x8F; // past U+10FFFF
+  } else {
+    return 0;
+  }
+  if (i + length > s.size()) {
+    return 0;
+  }
+  for (size_t k = 1; k < length; ++k) {
+    const unsigned char next = static_cast<unsigned char>(s[i + k]);
+    if (next < (k == 1 ? min : 0x80) || next > (k == 1 ? max : 0xBF)) {
+      return 0;
+    }
+  }
+  return length;
+}
+
+// Quoted and escaped as nlohmann's dump does it; bytes that are not UTF-8
+// become U+FFFD instead of making the dump throw
+void appendJsonString(std::string &out, const std::string &s) {
+  static const char hex[] = "0123456789abcdef";
+  out.push_back('"');
+  for (size_t i = 0; i < s.size(); ++i) {
+    const unsigned char c = static_cast<unsigned char>(s[i]);
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\b':
+      out += "\\b";
+      break;
+    case '\f':
+      out += "\\f";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (c < 0x20) {
+        out += "\\u00";
+        out.push_back(hex[c >> 4]);
+        out.push_back(hex[c & 0xF]);
+      } else if (c < 0x80) {
+        out.push_back(static_cast<char>(c));
+      } else if (const size_t length = utf8SequenceLength(s, i)) {
+        out.append(s, i, length);
+        i += length - 1;
+      } else {
+        out += "\xEF\xBF\xBD";
+      }
+    }
+  }
+  out.push_back('"');
+}
+
+void appendJsonKey(std::string &out, const char *key, bool first = false) {
+  if (!first) {
+    out.push_back(',');
+  }
+  out.push_back('"');
+  out += key;
+  out += "\":";
+}
+
+} // namespace
+
+void appendPropertyJson(std::string &out, const Property &prop) {
+  // Keys in the order a json object keeps them, sorted
+  out.push_back('{');
+  appendJsonKey(out, "addedDate", true);
+  appendJsonString(out, prop.addedDate);
+  appendJsonKey(out, "address");
+  appendJsonString(out, prop.address);
+  appendJsonKey(out, "agent");
+  appendJsonString(out, PropertyManager::propertyAgentToString(prop.agent));
+  appendJsonKey(out, "archivedDate");
+  appendJsonString(out, prop.archivedDate);
+  appendJsonKey(out, "city");
+  appendJsonString(out, prop.city);
+  appendJsonKey(out, "floors");
+  out += std::to_string(prop.floor);
+  appendJsonKey(out, "id");
+  appendJsonString(out, prop.id);
+  appendJsonKey(out, "img");
+  appendJsonString(out, prop.img);
+  appendJsonKey(out, "insideM2");
+  out += std::to_string(prop.buildingSize);
+  appendJsonKey(out, "landM2");
+  out += std::to_string(prop.landSize);
+  appendJsonKey(out, "latestOffer");
+  out += std::to_string(prop.latestOffer);
+  appendJsonKey(out, "previousPrices");
+  out.push_back('[');
+  for (size_t i = 0; i < prop.previousPrices.size(); ++i) {
+    if (i > 0) {
+      out.push_back(',');
+    }
+    out += std::to_string(prop.previousPrices[i]);
+  }
+  out.push_back(']');
+  appendJsonKey(out, "price");
+  out += std::to_string(prop.price);
+  appendJsonKey(out, "rooms");
+  out += std::to_string(prop.room);
+  appendJsonKey(out, "status");
+  appendJsonString(out, prop.status.empty() ? "active" : prop.status);
+  appendJsonKey(out, "type");
+  appendJsonString(out, PropertyManager::propertyTypeToString(prop.type));
+  appendJsonKey(out, "validDate");
+  appendJsonString(out, prop.validDate);
+  appendJsonKey(out, "website");
+  appendJsonString(out, prop.website);
+  appendJsonKey(out, "yearBuilt");
+  appendJsonString(out, prop.date);
+  out.push_back('}');
+}
+
 // Convert JSON array to entire property list
 std::vector<Property> jsonToProperties(const nlohmann::json &arr) {
   std::vector<Property> props;
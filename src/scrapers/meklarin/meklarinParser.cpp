@@ -1,12 +1,20 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <gumbo.h>
 #include <iostream>
-#include <regex>
+#include <limits>
+#include <random>
 #include <scrapers/include/PropertyManager.hpp>
+#include <scrapers/include/gumboArena.hpp>
 #include <scrapers/include/house_model.hpp>
 #include <scrapers/include/regexParser.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
 #include <scrapers/meklarin/meklarinModel.hpp>
 #include <scrapers/meklarin/meklarinParser.hpp>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 namespace HT::MEKLARIN {
 
 // A simple utility to get all text inside a node if it is <script> or similar
@@ -61,19 +69,16 @@ static std::string findAllPropertiesJsonMeklarin(GumboNode *node) {
 }
 
 // parse the Html with Gumbo
-std::vector<RawProperty> parseWithGumboMeklarin(std::string html) {
+std::vector<RawProperty> parseMeklarinDom(const std::string &html) {
   // 2) Parse with Gumbo
-  GumboOutput *output = gumbo_parse(html.c_str());
-  if (!output) {
+  GumboDocument document(html);
+  if (!document.output()) {
     std::cerr << "Failed to parse HTML.\n";
     return {};
   }
 
   // 3) Find script content with "var ALL_PROPERTIES"
-  std::string scriptText = findAllPropertiesJsonMeklarin(output->root);
-
-  // Clean up gumbo
-  gumbo_destroy_output(&kGumboDefaultOptions, output);
+  std::string scriptText = findAllPropertiesJsonMeklarin(document.root());
 
   if (scriptText.empty()) {
     std::cerr << "Could not find script with 'var ALL_PROPERTIES'!\n";
@@ -196,4 +201,832 @@ std::vector<RawProperty> parseWithGumboMeklarin(std::string html) {
   }
   return allProperties;
 }
+
+namespace {
+
+// The fields of an ALL_PROPERTIES entry the DOM path reads, and how it
+// reads them
+enum Field {
+  ID,
+  Areas,
+  Types,
+  FeaturedImage,
+  Permalink,
+  Build,
+  Address,
+  City,
+  Bedrooms,
+  HouseArea,
+  AreaSize,
+  New,
+  Featured,
+  Sold,
+  OpenHouse,
+  OpenHouseStartDate,
+  Price,
+  Bid,
+  NewBid,
+  BidValidUntil,
+  NewPrice,
+  FieldCount
+};
+
+constexpr std::string_view kFieldNames[FieldCount] = {
+    "ID", "areas", "types", "featured_image", "permalink", "build", "address",
+    "city", "bedrooms", "house_area", "area_size", "new", "featured", "sold",
+    "open_house", "open_house_start_date", "price", "bid", "new_bid",
+    "bid_valid_until", "new_price"};
+
+enum class Read { Text, Count, Flag };
+
+Read readOf(int field) {
+  switch (field) {
+  case Bedrooms:
+  case HouseArea:
+  case AreaSize:
+  case Price:
+  case Bid:
+    return Read::Count;
+  case New:
+  case Featured:
+  case Sold:
+  case OpenHouse:
+  case NewBid:
+    return Read::Flag;
+  default:
+    return Read::Text;
+  }
+}
+
+// The field a key names, FieldCount if none. Every key of every entry
+// comes through here, so the length and first letter pick the one name
+// worth comparing.
+int fieldOf(std::string_view key) {
+  if (key.size() < 2) {
+    return FieldCount;
+  }
+  int field = FieldCount;
+  switch (key.size()) {
+  case 2:
+    field = ID;
+    break;
+  case 3:
+    field = key[0] == 'n' ? New : Bid;
+    break;
+  case 4:
+    field = key[0] == 'c' ? City : Sold;
+    break;
+  case 5:
+    field = key[0] == 'a'   ? Areas
+            : key[0] == 't' ? Types
+            : key[0] == 'b' ? Build
+                            : Price;
+    break;
+  case 7:
+    field = key[0] == 'a' ? Address : NewBid;
+    break;
+  case 8:
+    field = key[0] == 'b' ? Bedrooms : Featured;
+    break;
+  case 9:
+    field = key[0] == 'p'   ? Permalink
+            : key[0] == 'a' ? AreaSize
+                            : NewPrice;
+    break;
+  case 10:
+    field = key[0] == 'h' ? HouseArea : OpenHouse;
+    break;
+  case 14:
+    field = FeaturedImage;
+    break;
+  case 15:
+    field = BidValidUntil;
+    break;
+  case 21:
+    field = OpenHouseStartDate;
+    break;
+  }
+  return field < FieldCount && key == kFieldNames[field] ? field
+                                                         : FieldCount;
+}
+
+// A field's value as the reader saw it; the last one wins, as in the DOM
+struct Value {
+  enum Type { Missing, Null, Bool, Integer, Unsigned, String };
+  Type type = Missing;
+  bool flag = false;
+  long long integer = 0;
+  unsigned long long number = 0;
+  // A string without escapes is left where it is in the literal; only
+  // one with escapes is unescaped into text
+  bool escaped = false;
+  std::string_view raw;
+  std::string text;
+};
+
+// What toString() makes of a string: its JSON dump without the quotes
+void appendDumped(std::string &out, const std::string &s) {
+  size_t plain = 0; // start of the run not yet copied
+  for (size_t i = 0; i < s.size(); ++i) {
+    const unsigned char c = static_cast<unsigned char>(s[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    out.append(s, plain, i - plain);
+    plain = i + 1;
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\b':
+      out += "\\b";
+      break;
+    case '\f':
+      out += "\\f";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default: {
+      char escaped[7];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out += escaped;
+    }
+    }
+  }
+  out.append(s, plain, std::string::npos);
+}
+
+// Reads the ALL_PROPERTIES array straight into RawProperty, one entry at a
+// time. It takes the shape the site serves: an array of flat objects whose
+// values are strings, integers, booleans and null, with the types the DOM
+// path expects. It is as strict as nlohmann::json about everything else
+// (UTF-8, escapes, numbers, trailing bytes) and stops on anything it does
+// not take, so the DOM path can run instead and odd pages still parse, or
+// fail, exactly as before.
+class PropertyReader {
+public:
+  PropertyReader(std::string_view literal, std::vector<RawProperty> &out)
+      : in(literal), out(out) {}
+
+  bool read() {
+    skipSpace();
+    if (!take('[')) {
+      return false;
+    }
+    skipSpace();
+    if (!take(']')) {
+      do {
+        skipSpace();
+        if (!readEntry()) {
+          return false;
+        }
+        skipSpace();
+      } while (take(','));
+      if (!take(']')) {
+        return false;
+      }
+    }
+    skipSpace();
+    return pos == in.size();
+  }
+
+private:
+  bool take(char c) {
+    if (pos < in.size() && in[pos] == c) {
+      ++pos;
+      return true;
+    }
+    return false;
+  }
+
+  void skipSpace() {
+    while (pos < in.size() && (in[pos] == ' ' || in[pos] == '\t' ||
+                               in[pos] == '\n' || in[pos] == '\r')) {
+      ++pos;
+    }
+  }
+
+  bool readEntry() {
+    if (!take('{')) {
+      return false; // not an object: the DOM path reads it as empty
+    }
+    for (auto &value : values) {
+      value.type = Value::Missing;
+    }
+    skipSpace();
+    if (!take('}')) {
+      do {
+        skipSpace();
+        std::string_view name;
+        if (!readPlainString(name)) {
+          if (!readString(key)) {
+            return false;
+          }
+          name = key;
+        }
+        skipSpace();
+        if (!take(':')) {
+          return false;
+        }
+        skipSpace();
+        const int field = fieldOf(name);
+        if (!readValue(field < FieldCount ? values[field] : unread)) {
+          return false;
+        }
+        skipSpace();
+      } while (take(','));
+      if (!take('}')) {
+        return false;
+      }
+    }
+    return finishEntry();
+  }
+
+  bool readValue(Value &value) {
+    if (pos >= in.size()) {
+      return false;
+    }
+    switch (in[pos]) {
+    case '"':
+      value.type = Value::String;
+      value.escaped = !readPlainString(value.raw);
+      return !value.escaped || readString(value.text);
+    case 't':
+      value.type = Value::Bool;
+      value.flag = true;
+      return readWord("true");
+    case 'f':
+      value.type = Value::Bool;
+      value.flag = false;
+      return readWord("false");
+    case 'n':
+      value.type = Value::Null;
+      return readWord("null");
+    default:
+      return readInteger(value); // objects and arrays end up here too
+    }
+  }
+
+  bool readWord(std::string_view word) {
+    if (in.substr(pos, word.size()) != word) {
+      return false;
+    }
+    pos += word.size();
+    return true;
+  }
+
+  // -?(0|[1-9][0-9]*) that fits in 64 bits; anything else would be a float
+  // to nlohmann::json
+  bool readInteger(Value &value) {
+    const bool negative = take('-');
+    const size_t start = pos;
+    unsigned long long number = 0;
+    while (pos < in.size() && isDigit(in[pos])) {
+      const unsigned digit = in[pos] - '0';
+      if (number > (~0ULL - digit) / 10) {
+        return false;
+      }
+      number = number * 10 + digit;
+      ++pos;
+    }
+    if (pos == start || (in[start] == '0' && pos - start > 1) ||
+        (pos < in.size() &&
+         (in[pos] == '.' || in[pos] == 'e' || in[pos] == 'E'))) {
+      return false;
+    }
+    if (!negative) {
+      value.type = Value::Unsigned;
+      value.number = number;
+    } else if (number <= 1ULL << 63) {
+      value.type = Value::Integer;
+      value.integer = static_cast<long long>(0 - number);
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  int hexDigit(char c) const {
+    if (isDigit(c)) {
+      return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+
+  // The 4 hex digits of a \u escape, -1 if they are not
+  long readHex4() {
+    if (in.size() - pos < 4) {
+      return -1;
+    }
+    long value = 0;
+    for (int i = 0; i < 4; ++i) {
+      const int digit = hexDigit(in[pos + i]);
+      if (digit < 0) {
+        return -1;
+      }
+      value = value * 16 + digit;
+    }
+    pos += 4;
+    return value;
+  }
+
+  static void appendUtf8(std::string &out, long cp) {
+    if (cp < 0x80) {
+      out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+      out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+      out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+      out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+  }
+
+  // Length of the well-formed UTF-8 sequence at at, 0 if it is not one
+  size_t utf8Length(size_t at) const {
+    auto byte = [&](size_t i) -> unsigned {
+      return at + i < in.size() ? static_cast<unsigned char>(in[at + i]) : 0;
+    };
+    auto cont = [&](size_t i, unsigned lo = 0x80, unsigned hi = 0xBF) {
+      return byte(i) >= lo && byte(i) <= hi;
+    };
+    const unsigned lead = byte(0);
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      return cont(1) ? 2 : 0;
+    }
+    if (lead >= 0xE0 && lead <= 0xEF) {
+      const unsigned lo = lead == 0xE0 ? 0xA0 : 0x80;
+      const unsigned hi = lead == 0xED ? 0x9F : 0xBF;
+      return cont(1, lo, hi) && cont(2) ? 3 : 0;
+    }
+    if (lead >= 0xF0 && lead <= 0xF4) {
+      const unsigned lo = lead == 0xF0 ? 0x90 : 0x80;
+      const unsigned hi = lead == 0xF4 ? 0x8F : 0xBF;
+      return cont(1, lo, hi) && cont(2) && cont(3) ? 4 : 0;
+    }
+    return 0;
+  }
+
+  // A string with no escapes in it, as a view into the literal. False, with
+  // pos left on the opening quote, if it has one or is not well-formed;
+  // readString takes it from there.
+  bool readPlainString(std::string_view &out) {
+    if (pos >= in.size() || in[pos] != '"') {
+      return false;
+    }
+    size_t end = pos + 1;
+    while (end < in.size()) {
+      const unsigned char c = static_cast<unsigned char>(in[end]);
+      if (c == '"') {
+        out = in.substr(pos + 1, end - pos - 1);
+        pos = end + 1;
+        return true;
+      }
+      if (c == '\\' || c < 0x20) {
+        return false;
+      }
+      if (c < 0x80) {
+        ++end;
+        continue;
+      }
+      const size_t length = utf8Length(end);
+      if (length == 0) {
+        return false;
+      }
+      end += length;
+    }
+    return false;
+  }
+
+  // A string, unescaped into out; runs of plain bytes are copied at once
+  bool readString(std::string &out) {
+    if (!take('"')) {
+      return false;
+    }
+    out.clear();
+    while (pos < in.size()) {
+      size_t run = pos;
+      while (run < in.size()) {
+        const unsigned char c = static_cast<unsigned char>(in[run]);
+        if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) {
+          break;
+        }
+        ++run;
+      }
+      out.append(in.data() + pos, run - pos);
+      pos = run;
+      if (pos >= in.size()) {
+        break;
+      }
+
+      const unsigned char c = static_cast<unsigned char>(in[pos]);
+      if (c == '"') {
+        ++pos;
+        return true;
+      }
+      if (c < 0x20) {
+        return false; // control characters have to be escaped
+      }
+      if (c >= 0x80) {
+        const size_t length = utf8Length(pos);
+        if (length == 0) {
+          return false;
+        }
+        out.append(in.data() + pos, length);
+        pos += length;
+        continue;
+      }
+
+      ++pos; // the backslash
+      if (pos >= in.size()) {
+        return false;
+      }
+      const char escaped = in[pos++];
+      switch (escaped) {
+      case '"':
+      case '\\':
+      case '/':
+        out.push_back(escaped);
+        break;
+      case 'b':
+        out.push_back('\b');
+        break;
+      case 'f':
+        out.push_back('\f');
+        break;
+      case 'n':
+        out.push_back('\n');
+        break;
+      case 'r':
+        out.push_back('\r');
+        break;
+      case 't':
+        out.push_back('\t');
+        break;
+      case 'u': {
+        long cp = readHex4();
+        if (cp < 0 || (cp >= 0xDC00 && cp <= 0xDFFF)) {
+          return false;
+        }
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+          if (!take('\\') || !take('u')) {
+            return false;
+          }
+          const long low = readHex4();
+          if (low < 0xDC00 || low > 0xDFFF) {
+            return false;
+          }
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        }
+        appendUtf8(out, cp);
+        break;
+      }
+      default:
+        return false;
+      }
+    }
+    return false; // unterminated
+  }
+
+  static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+  // What toString() gives for the field
+  void text(int f, std::string &out) const {
+    const Value &v = values[f];
+    switch (v.type) {
+    case Value::Bool:
+      out = v.flag ? "true" : "false";
+      break;
+    case Value::Integer:
+      out = std::to_string(v.integer);
+      break;
+    case Value::Unsigned:
+      out = std::to_string(v.number);
+      break;
+    case Value::String:
+      // Nothing in a string without escapes is escaped again by the dump
+      if (v.escaped) {
+        appendDumped(out, v.text);
+      } else {
+        out.append(v.raw);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  // What parseInt() gives for the field, without its copies: all its digits
+  // as one number. False where std::stoi would throw.
+  bool count(int f, int &out) const {
+    const Value &v = values[f];
+    long long number = 0;
+    for (char c : v.escaped ? std::string_view(v.text) : v.raw) {
+      if (isDigit(c)) {
+        number = number * 10 + (c - '0');
+        if (number > std::numeric_limits<int>::max()) {
+          return false;
+        }
+      }
+    }
+    out = static_cast<int>(number);
+    return true;
+  }
+
+  // Converts the entry as the DOM path would; false where it would throw
+  bool finishEntry() {
+    int counts[FieldCount] = {};
+    for (int f = 0; f < FieldCount; ++f) {
+      const Value &v = values[f];
+      if (v.type == Value::Missing) {
+        continue;
+      }
+      switch (readOf(f)) {
+      case Read::Text:
+        break;
+      case Read::Count:
+        if (v.type != Value::String || !count(f, counts[f])) {
+          return false;
+        }
+        break;
+      case Read::Flag:
+        if (v.type != Value::Bool) {
+          return false;
+        }
+        break;
+      }
+    }
+
+    RawProperty &property = out.emplace_back();
+    text(Address, property.address);
+    text(City, property.city);
+    text(Areas, property.postNum);
+    property.id = PropertyManager::cleanId(property.address + property.city +
+                                           property.postNum);
+    property.website = "https://www.meklarin.fo/";
+    std::string types;
+    text(Types, types);
+    property.type = PropertyManager::extractPropertyTypeMeklarin(types);
+    property.houseNum = property.address;
+    property.price = std::to_string(counts[Price]);
+    property.latestOffer = std::to_string(counts[Bid]);
+    text(BidValidUntil, property.validDate);
+    text(OpenHouseStartDate, property.date);
+    property.buildingSize = std::to_string(counts[AreaSize]);
+    property.landSize = std::to_string(counts[HouseArea]);
+    property.room = std::to_string(counts[Bedrooms]);
+    property.floor = "0";
+    text(FeaturedImage, property.img);
+    property.agent =
+        PropertyManager::propertyAgentToString(RealEstateAgent::Meklarin);
+    return true;
+  }
+
+  std::string_view in;
+  size_t pos = 0;
+  std::vector<RawProperty> &out;
+  Value values[FieldCount];
+  Value unread;
+  std::string key;
+};
+
+// The page embeds the listings as
+//   var ALL_PROPERTIES = JSON.parse('[{"ID":29032,...}]');
+// Finds the literal with substring scans (std::string_view::find runs on
+// memchr) and reads it into out without copying it or building a DOM.
+// False if the page does not look like that.
+bool readAllProperties(const std::string &html, std::vector<RawProperty> &out) {
+  const std::string_view page(html);
+  constexpr std::string_view needle = "JSON.parse('";
+  auto start = page.find(needle);
+  if (start == std::string_view::npos) {
+    return false;
+  }
+  // The declaration sits just before the call, so look back from it first
+  constexpr std::string_view declaration = "var ALL_PROPERTIES";
+  if (page.rfind(declaration, start) == std::string_view::npos &&
+      page.find(declaration, start) == std::string_view::npos) {
+    return false;
+  }
+  start += needle.size();
+  const auto end = page.find("')", start);
+  if (end == std::string_view::npos) {
+    return false;
+  }
+
+  // An entry takes a few hundred bytes of the literal
+  const std::string_view literal = page.substr(start, end - start);
+  out.reserve(out.size() + literal.size() / 256);
+  PropertyReader reader(literal, out);
+  if (!reader.read()) {
+    out.clear();
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+std::vector<RawProperty> parseWithGumboMeklarin(const std::string &html) {
+  std::vector<RawProperty> properties;
+  if (readAllProperties(html, properties)) {
+    return properties;
+  }
+  return parseMeklarinDom(html);
+}
+
+int benchMeklarinParser(const std::string &rawHtmlDir) {
+  using Clock = std::chrono::steady_clock;
+
+  std::vector<std::string> pages;
+  std::unordered_set<std::string> seenHashes;
+  for (const auto &record : archivedSnapshotRecords(rawHtmlDir)) {
+    if (record.url.find("meklarin") == std::string::npos ||
+        !seenHashes.insert(record.hash).second) {
+      continue;
+    }
+    std::string page;
+    if (loadSnapshotPage(rawHtmlDir, record, page)) {
+      pages.push_back(std::move(page));
+    }
+  }
+  if (pages.empty()) {
+    std::cerr << "No Meklarin snapshots found in " << rawHtmlDir << "\n";
+    return 1;
+  }
+
+  size_t properties = 0;
+  size_t fallbacks = 0;
+  size_t mismatches = 0;
+  for (const auto &page : pages) {
+    std::vector<RawProperty> fast;
+    if (!readAllProperties(page, fast)) {
+      ++fallbacks;
+    }
+    const auto dom = parseMeklarinDom(page);
+    properties += dom.size();
+    if (describeRawProperties(parseWithGumboMeklarin(page)) !=
+        describeRawProperties(dom)) {
+      ++mismatches;
+    }
+  }
+
+  // Microseconds per page over about `wanted` parses, at least one pass
+  auto timePerPage = [&pages](auto parse, size_t wanted) {
+    const size_t rounds = std::max<size_t>(1, wanted / pages.size());
+    const auto start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+      for (const auto &page : pages) {
+        parse(page);
+      }
+    }
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    return seconds * 1e6 / static_cast<double>(rounds * pages.size());
+  };
+  // The streaming reader is cheap enough to time over ten times as many
+  // pages, which keeps its figure from drifting between runs
+  const double domUs = timePerPage(parseMeklarinDom, 200);
+  const double fastUs = timePerPage(parseWithGumboMeklarin, 2000);
+
+  std::cout << pages.size() << " distinct pages, " << properties
+            << " properties\n";
+  std::cout << "Gumbo + json DOM: " << domUs << " us per page\n";
+  std::cout << "Streaming reader: " << fastUs << " us per page ("
+            << (fastUs > 0 ? domUs / fastUs : 0.0) << "x faster)\n";
+  if (fallbacks > 0) {
+    std::cout << fallbacks << " pages fell back to the DOM path\n";
+  }
+  if (mismatches > 0) {
+    std::cerr << mismatches << " pages parsed differently\n";
+    return 1;
+  }
+  return 0;
+}
+
+namespace {
+
+// What a parse gave, or that it threw, for comparing the two paths
+std::string outcome(std::vector<RawProperty> (*parse)(const std::string &),
+                    const std::string &page) {
+  try {
+    return describeRawProperties(parse(page));
+  } catch (const std::exception &e) {
+    return std::string("threw: ") + e.what();
+  }
+}
+
+} // namespace
+
+int verifyMeklarinReader(const std::string &rawHtmlDir, size_t count,
+                         unsigned seed) {
+  std::vector<std::string> pages;
+  std::unordered_set<std::string> seenHashes;
+  for (const auto &record : archivedSnapshotRecords(rawHtmlDir)) {
+    if (record.url.find("meklarin") == std::string::npos ||
+        !seenHashes.insert(record.hash).second) {
+      continue;
+    }
+    std::string page;
+    if (loadSnapshotPage(rawHtmlDir, record, page) &&
+        page.find("JSON.parse('") != std::string::npos) {
+      pages.push_back(std::move(page));
+    }
+  }
+  if (pages.empty()) {
+    std::cerr << "No Meklarin snapshots found in " << rawHtmlDir << "\n";
+    return 1;
+  }
+
+  // Bytes that make or break JSON: structure, escapes, digits, a control
+  // character and the pieces of broken or surrogate UTF-8
+  static const char kBytes[] = "{}[]\",:\\/u0129aefnrtl -\x01\xc3\xb0\xed\xa0";
+  std::mt19937 rng(seed);
+  size_t fallbacks = 0;
+  size_t mismatches = 0;
+  std::string firstMismatch;
+
+  // The DOM path reports every literal it cannot parse; that is expected
+  // here, so its messages are dropped until the run is over
+  std::streambuf *errors = std::cerr.rdbuf(nullptr);
+  for (size_t i = 0; i < count; ++i) {
+    std::string page = pages[i % pages.size()];
+    constexpr std::string_view call = "JSON.parse('";
+    const size_t start = page.find(call) + call.size();
+    const size_t end = page.find("')", start);
+    if (end == std::string::npos || end <= start) {
+      continue;
+    }
+    // One to three bytes of the literal replaced, inserted or removed. Half
+    // of them land just past a token boundary, where numbers, escapes and
+    // keys start, rather than anywhere in a long run of text.
+    const int edits = 1 + static_cast<int>(rng() % 3);
+    for (int e = 0; e < edits; ++e) {
+      size_t at = start + rng() % (end - start);
+      if (rng() % 2 == 0) {
+        const size_t boundary = page.find_first_of(":,\"\\[{", at);
+        if (boundary != std::string::npos && boundary + 1 < end) {
+          at = boundary + 1;
+        }
+      }
+      const char byte = kBytes[rng() % (sizeof(kBytes) - 1)];
+      switch (rng() % 3) {
+      case 0:
+        page[at] = byte;
+        break;
+      case 1:
+        page.insert(page.begin() + at, byte);
+        break;
+      default:
+        page.erase(at, 1);
+        break;
+      }
+    }
+
+    std::vector<RawProperty> fast;
+    if (!readAllProperties(page, fast)) {
+      ++fallbacks;
+    }
+    if (outcome(parseWithGumboMeklarin, page) !=
+        outcome(parseMeklarinDom, page)) {
+      if (mismatches++ == 0) {
+        firstMismatch = page.substr(start, end - start);
+      }
+    }
+  }
+  std::cerr.rdbuf(errors);
+  std::cerr.clear();
+
+  std::cout << count << " mutated pages, " << fallbacks
+            << " handed to the DOM path, " << mismatches
+            << " parsed differently\n";
+  if (mismatches > 0) {
+    std::cerr << "First literal parsed differently:\n"
+              << firstMismatch << "\n";
+    return 1;
+  }
+  return 0;
+}
 } // namespace HT::MEKLARIN
@@ -2,5 +2,24 @@
 #include <scrapers/include/house_model.hpp>
 namespace HT::MEKLARIN {
 
-std::vector<RawProperty> parseWithGumboMeklarin(std::string html);
+// Bump when the parser output changes (see parseCache.hpp)
+constexpr int kParserVersion = 1;
+
+// Reads the listings the homepage embeds as a JSON literal straight off the
+// page, without a DOM; a page it does not recognise goes to
+// parseMeklarinDom
+std::vector<RawProperty> parseWithGumboMeklarin(const std::string &html);
+
+// The old path: finds the script with Gumbo and parses the literal into a
+// json DOM
+std::vector<RawProperty> parseMeklarinDom(const std::string &html);
+
+// Times both paths on every archived Meklarin page and checks they agree
+int benchMeklarinParser(const std::string &rawHtmlDir);
+
+// Runs both paths on count copies of the archived Meklarin pages, each with
+// a few random bytes of its listings literal changed, and checks they give
+// the same properties (or the same exception); 1 if any copy differs
+int verifyMeklarinReader(const std::string &rawHtmlDir, size_t count,
+                         unsigned seed);
 }
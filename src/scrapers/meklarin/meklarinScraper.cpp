@@ -3,6 +3,7 @@
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include <scrapers/include/PropertyManager.hpp>
+#include <scrapers/include/fetchEngine.hpp>
 #include <scrapers/include/filesystem.hpp>
 #include <scrapers/include/house_model.hpp>
 #include <scrapers/include/parser.hpp>
@@ -14,12 +15,15 @@
 
 namespace HT {
 
-int meklarinRun(bool downloadNewHtml) {
+// Meklarin lists every property on its front page
+std::vector<FetchJob> meklarinJobs() {
+  return {{"https://www.meklarin.fo/", PropertyType::Undefined,
+           RealEstateAgent::Meklarin, {}}};
+}
 
-  //  1) Download page into `html`
-  std::string url = "https://www.meklarin.fo/";
+int meklarinRun(bool downloadNewHtml, const FetchOptions &options) {
   if (downloadNewHtml)
-    std::string html = HT::downloadAndSaveHtml(url, RealEstateAgent::Meklarin);
+    HT::fetchAndSaveAll(meklarinJobs(), options);
   return 0;
 }
 
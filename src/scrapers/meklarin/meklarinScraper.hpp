@@ -1,5 +1,7 @@
 // meklarinScraper.hpp
 #pragma once
+#include <scrapers/include/fetchEngine.hpp>
 namespace HT {
-int meklarinRun(bool downloadNewHtml);
+std::vector<FetchJob> meklarinJobs();
+int meklarinRun(bool downloadNewHtml, const FetchOptions &options = {});
 }
@@ -0,0 +1,220 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <scrapers/include/parseCache.hpp>
+
+namespace HT {
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kRecordMagic[4] = {'H', 'T', 'P', 'C'};
+constexpr uint64_t kHeaderSize = 12; // magic, key size, value size
+
+void putU32(std::string &out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint32_t getU32(const char *data) {
+  uint32_t value = 0;
+  for (int i = 3; i >= 0; --i) {
+    value = (value << 8) | static_cast<unsigned char>(data[i]);
+  }
+  return value;
+}
+
+void putString(std::string &out, const std::string &s) {
+  putU32(out, static_cast<uint32_t>(s.size()));
+  out += s;
+}
+
+// Reads a string at pos of [data, data + size), false if it runs past it
+bool getString(const char *data, uint64_t size, uint64_t &pos,
+               std::string &s) {
+  if (pos + 4 > size) {
+    return false;
+  }
+  const uint64_t length = getU32(data + pos);
+  pos += 4;
+  if (length > size - pos) {
+    return false;
+  }
+  s.assign(data + pos, length);
+  pos += length;
+  return true;
+}
+
+std::string encodeProperties(const std::vector<RawProperty> &properties) {
+  std::string out;
+  putU32(out, static_cast<uint32_t>(properties.size()));
+  for (const auto &p : properties) {
+    for (const std::string *field :
+         {&p.id, &p.website, &p.address, &p.houseNum, &p.city, &p.postNum,
+          &p.price, &p.latestOffer, &p.validDate, &p.date, &p.buildingSize,
+          &p.landSize, &p.room, &p.floor, &p.img, &p.type, &p.agent}) {
+      putString(out, *field);
+    }
+    putU32(out, static_cast<uint32_t>(p.previousPrices.size()));
+    for (const auto &price : p.previousPrices) {
+      putString(out, price);
+    }
+  }
+  return out;
+}
+
+bool decodeProperties(const char *data, uint64_t size,
+                      std::vector<RawProperty> &properties) {
+  properties.clear();
+  uint64_t pos = 0;
+  if (size < 4) {
+    return false;
+  }
+  const uint32_t count = getU32(data);
+  pos += 4;
+  for (uint32_t i = 0; i < count; ++i) {
+    RawProperty &p = properties.emplace_back();
+    for (std::string *field :
+         {&p.id, &p.website, &p.address, &p.houseNum, &p.city, &p.postNum,
+          &p.price, &p.latestOffer, &p.validDate, &p.date, &p.buildingSize,
+          &p.landSize, &p.room, &p.floor, &p.img, &p.type, &p.agent}) {
+      if (!getString(data, size, pos, *field)) {
+        return false;
+      }
+    }
+    if (pos + 4 > size) {
+      return false;
+    }
+    const uint32_t priceCount = getU32(data + pos);
+    pos += 4;
+    for (uint32_t j = 0; j < priceCount; ++j) {
+      if (!getString(data, size, pos, p.previousPrices.emplace_back())) {
+        return false;
+      }
+    }
+  }
+  return pos == size;
+}
+
+std::string encodeRecord(const std::string &key, const char *value,
+                         uint64_t valueSize) {
+  std::string out(kRecordMagic, 4);
+  putU32(out, static_cast<uint32_t>(key.size()));
+  putU32(out, static_cast<uint32_t>(valueSize));
+  out += key;
+  out.append(value, valueSize);
+  return out;
+}
+
+} // namespace
+
+ParseCache::ParseCache(std::string path) : path(std::move(path)) {}
+
+bool ParseCache::load() {
+  data.clear();
+  index.clear();
+  used.clear();
+  hitCount = 0;
+  savedEnd = 0;
+
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs.is_open()) {
+    return false; // nothing cached yet
+  }
+  data.assign(std::istreambuf_iterator<char>(ifs),
+              std::istreambuf_iterator<char>());
+
+  uint64_t pos = 0;
+  while (pos + kHeaderSize <= data.size() &&
+         std::memcmp(data.data() + pos, kRecordMagic, 4) == 0) {
+    const uint64_t keySize = getU32(data.data() + pos + 4);
+    const uint64_t valueSize = getU32(data.data() + pos + 8);
+    const uint64_t valueStart = pos + kHeaderSize + keySize;
+    if (valueStart + valueSize > data.size()) {
+      break; // cut short by a crash
+    }
+    index.insert_or_assign(data.substr(pos + kHeaderSize, keySize),
+                           std::make_pair(valueStart, valueSize));
+    pos = valueStart + valueSize;
+  }
+  if (pos < data.size()) {
+    std::cerr << "Ignoring " << data.size() - pos
+              << " unreadable bytes at the end of " << path << "\n";
+    data.resize(pos);
+  }
+  savedEnd = pos;
+  return true;
+}
+
+bool ParseCache::find(const std::string &key,
+                      std::vector<RawProperty> &properties) {
+  auto it = index.find(key);
+  if (it == index.end() ||
+      !decodeProperties(data.data() + it->second.first, it->second.second,
+                        properties)) {
+    return false;
+  }
+  used.insert(key);
+  ++hitCount;
+  return true;
+}
+
+void ParseCache::add(const std::string &key,
+                     const std::vector<RawProperty> &properties) {
+  const std::string value = encodeProperties(properties);
+  const uint64_t valueStart = data.size() + kHeaderSize + key.size();
+  data += encodeRecord(key, value.data(), value.size());
+  index.insert_or_assign(key, std::make_pair(valueStart, value.size()));
+  used.insert(key);
+}
+
+bool ParseCache::save(bool dropUnused) {
+  std::error_code ec;
+  fs::create_directories(fs::path(path).parent_path(), ec);
+
+  if (dropUnused) {
+    std::string kept;
+    for (const auto &key : used) {
+      const auto &[start, size] = index.at(key);
+      kept += encodeRecord(key, data.data() + start, size);
+    }
+    const std::string tmpPath = path + ".tmp";
+    {
+      std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+      ofs.write(kept.data(), static_cast<std::streamsize>(kept.size()));
+      if (!ofs) {
+        std::cerr << "Error writing file: " << tmpPath << std::endl;
+        return false;
+      }
+    }
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+      std::cerr << "Error renaming " << tmpPath << ": " << ec.message()
+                << "\n";
+      return false;
+    }
+    return load();
+  }
+
+  if (savedEnd == data.size()) {
+    return true;
+  }
+  // Drop a torn record left by an earlier run before appending
+  if (fs::exists(path, ec) && fs::file_size(path, ec) != savedEnd) {
+    fs::resize_file(path, savedEnd, ec);
+  }
+  std::ofstream ofs(path, std::ios::binary | std::ios::app);
+  ofs.write(data.data() + savedEnd,
+            static_cast<std::streamsize>(data.size() - savedEnd));
+  if (!ofs) {
+    std::cerr << "Error writing file: " << path << std::endl;
+    return false;
+  }
+  savedEnd = data.size();
+  return true;
+}
+
+} // namespace HT
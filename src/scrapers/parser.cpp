@@ -1,3 +1,4 @@
+#include <cstring>
 #include <gumbo.h>
 #include <iostream>
 #include <regex>
@@ -8,25 +9,29 @@
 
 namespace HT {
 
-// Helper function to get the node’s inner text
-std::string getNodeText(GumboNode *node) {
+// Helper function to append the node’s inner text to out
+void appendNodeText(GumboNode *node, std::string &out) {
   if (!node)
-    return "";
+    return;
   // If it’s a text node
   if (node->type == GUMBO_NODE_TEXT) {
-    return std::string(node->v.text.text);
+    out += node->v.text.text;
+    return;
   }
   // If it’s an element node, walk children
   if (node->type == GUMBO_NODE_ELEMENT) {
-    std::string result;
     GumboVector *children = &node->v.element.children;
     for (unsigned int i = 0; i < children->length; ++i) {
-      GumboNode *child = static_cast<GumboNode *>(children->data[i]);
-      result += getNodeText(child);
+      appendNodeText(static_cast<GumboNode *>(children->data[i]), out);
     }
-    return result;
   }
-  return "";
+}
+
+// Helper function to get the node’s inner text
+std::string getNodeText(GumboNode *node) {
+  std::string result;
+  appendNodeText(node, result);
+  return result;
 }
 
 // Utility: Return the class attribute of a node, or nullptr if none.
@@ -37,7 +42,7 @@ const char *getClassAttr(GumboNode *node) {
   GumboVector *attrs = &node->v.element.attributes;
   for (unsigned int i = 0; i < attrs->length; i++) {
     GumboAttribute *attr = static_cast<GumboAttribute *>(attrs->data[i]);
-    if (std::string(attr->name) == "class") {
+    if (std::strcmp(attr->name, "class") == 0) {
       return attr->value;
     }
   }
@@ -50,7 +55,7 @@ const char *getAttribute(const GumboVector *attrs, const char *name) {
     return nullptr;
   for (unsigned int i = 0; i < attrs->length; i++) {
     GumboAttribute *attr = static_cast<GumboAttribute *>(attrs->data[i]);
-    if (std::string(attr->name) == std::string(name)) {
+    if (std::strcmp(attr->name, name) == 0) {
       return attr->value;
     }
   }
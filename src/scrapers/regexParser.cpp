@@ -1,7 +1,7 @@
 #include <iostream>
 #include <nlohmann/json.hpp>
-#include <regex>
 #include <scrapers/include/house_model.hpp>
+#include <scrapers/include/textScan.hpp>
 
 namespace HT {
 
@@ -59,15 +59,8 @@ int parseAreaToInt(const std::string &s) {
     return 0;
   }
 
-  static const std::regex firstNumber(R"((\d[\d\.,]*))");
-  std::smatch match;
-  if (!std::regex_search(tmp, match, firstNumber)) {
-    return 0;
-  }
-
-  std::string numberToken = match[1].str();
   std::string digitsOnly;
-  for (char c : numberToken) {
+  for (char c : firstNumber(tmp)) {
     if (std::isdigit(static_cast<unsigned char>(c))) {
       digitsOnly.push_back(c);
     }
@@ -91,12 +84,8 @@ std::string parseId(const std::string &s) {
   // - approach 2: or any custom approach you prefer
   //
   // e.g. "Marknagilsvegur 50""Streymoy suður" -> "Marknagilsvegur 50, Streymoy
-  // suður" A simple approach is to do a regex replace of `""` with `, `
-
-  static std::regex doubleQuoteRegex(R"("")"); // matches ""
-  tmp = std::regex_replace(tmp, doubleQuoteRegex, ", ");
-
-  return tmp;
+  // suður" A simple approach is to replace `""` with `, `
+  return replaceAll(tmp, "\"\"", ", ");
 }
 
 // parse the "previousPrices" which is an array, but appears empty in your
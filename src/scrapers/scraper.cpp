@@ -1,97 +1,31 @@
-#include <curl/curl.h>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <scrapers/include/PropertyManager.hpp>
+#include <scrapers/include/blobStore.hpp>
+#include <scrapers/include/fetchEngine.hpp>
 #include <scrapers/include/filesystem.hpp>
 #include <scrapers/include/house_model.hpp>
 #include <scrapers/include/scraper.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
+#include <scrapers/include/snapshotStream.hpp>
+#include <unordered_set>
 
 namespace HT {
 
-enum class WriteMode { ToMemory, ToFile };
-
-struct WriteData {
-  WriteMode mode;
-  std::string *outString; // if mode == ToMemory
-  std::ofstream outFile;  // if mode == ToFile
-};
-
-static size_t WriteCallback(void *contents, size_t size, size_t nmemb,
-                            void *userp) {
-  size_t totalBytes = size * nmemb;
-  WriteData *wd = static_cast<WriteData *>(userp);
-
-  if (wd->mode == WriteMode::ToMemory) {
-    // Append to the output string
-    wd->outString->append(static_cast<char *>(contents), totalBytes);
-  } else if (wd->mode == WriteMode::ToFile) {
-    // Write to file
-    wd->outFile.write(static_cast<char *>(contents), totalBytes);
-  }
-
-  return totalBytes;
-}
-
-std::string extractHtmlFromJson(const std::string &url) {
-
-  // Try to parse it as JSON
-  try {
-    auto j = nlohmann::json::parse(url);
-
-    // If it contains an "html" field, extract that
-    if (j.contains("html") && j["html"].is_string()) {
-      return j["html"].get<std::string>(); // Return HTML string from JSON
-    }
-
-    // JSON is valid, but doesn't contain "html"
-    return url;
-  } catch (const nlohmann::json::parse_error &e) {
+std::string extractHtmlFromJson(const std::string &payload) {
+  std::string html;
+  HtmlPayloadExtractor extractor([&html](const char *data, size_t size) {
+    html.append(data, size);
+    return true;
+  });
+  if (!extractor.feed(payload.data(), payload.size()) || !extractor.finish()) {
     // Not valid JSON, treat as raw HTML
-    std::cerr << "Parse error JSON" << e.what() << "\n";
-    return url;
-  } catch (const std::exception &e) {
-    // Some other exception, just print/log
-    std::cerr << "Exception while parsing JSON: " << e.what() << "\n";
-    return url;
-  }
-}
-
-// Download HTML via libcurl
-bool downloadData(const std::string &url, WriteData &wd) {
-  CURL *curl = curl_easy_init();
-  if (!curl) {
-    std::cerr << "Failed to init curl\n";
-    return false;
+    return payload;
   }
-
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &wd);
-
-  CURLcode res = curl_easy_perform(curl);
-  if (res != CURLE_OK) {
-    std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res)
-              << std::endl;
-    curl_easy_cleanup(curl);
-    return false;
-  }
-
-  curl_easy_cleanup(curl);
-  return true;
-}
-
-bool downloadToString(const std::string &url, std::string &outString) {
-  // Ensure the output is empty or in a known state
-  outString.clear();
-
-  // Prepare our WriteData struct to store data in memory
-  WriteData wd;
-  wd.mode = WriteMode::ToMemory;
-  wd.outString = &outString;
-
-  // Actually do the download
-  return downloadData(url, wd);
+  return html;
 }
 
 std::string downloadAndSaveHtml(const std::string &url) {
@@ -105,55 +39,93 @@ std::string downloadAndSaveHtml(const std::string &url, RealEstateAgent agent) {
   return downloadAndSaveHtml(url, pt, agent);
 }
 
-bool downloadToFile(const std::string &url, const std::string &filePath) {
-  WriteData wd;
-  wd.mode = WriteMode::ToFile;
-
-  // Open the file in binary mode
-  wd.outFile.open(filePath, std::ios::binary);
-  if (!wd.outFile.is_open()) {
-    std::cerr << "Failed to open file for writing: " << filePath << "\n";
-    return false;
+std::string saveHtmlSnapshot(const std::string &url, PropertyType propType,
+                             RealEstateAgent agent, const std::string &html) {
+  // Store the body once per distinct content
+  std::string hash = HT::storeBlob(HT::snapshotDir(), html);
+  if (hash.empty()) {
+    return "";
   }
-
-  bool success = downloadData(url, wd);
-  wd.outFile.close();
-  return success;
+  return saveSnapshotEntry(url, propType, agent, hash);
 }
 
-std::string downloadAndSaveHtml(const std::string &url, PropertyType propType,
-                                RealEstateAgent agent) {
-  // 1) Download
-  std::string html;
-  bool success = HT::downloadToString(url, html);
-  html = extractHtmlFromJson(html);
-  if (html.empty() || !success) {
-    std::cerr << "Download failed\n";
+std::string saveSnapshotEntry(const std::string &url, PropertyType propType,
+                              RealEstateAgent agent, const std::string &hash) {
+  // 1) Build a new timestamped filename
+  std::string filePath = HT::makeTimestampedFilename();
+
+  // 2) Record this fetch as a small entry pointing at the body
+  nlohmann::json j;
+  j["url"] = url;
+  j["type"] = PropertyManager::propertyTypeToString(propType);
+  j["agent"] = PropertyManager::propertyAgentToString(agent);
+  j["timestamp"] = std::time(nullptr); // or store as string
+  j["hash"] = hash;
+
+  std::ofstream ofs(filePath);
+  if (!ofs.is_open()) {
+    std::cerr << "Error opening file: " << filePath << std::endl;
     return "";
   }
 
-  // 2) Build a new timestamped filename
+  ofs << j.dump(4);
+  ofs.close();
+
+  SnapshotRecord record;
+  record.file = std::filesystem::path(filePath).filename().string();
+  record.url = url;
+  record.type = j["type"].get<std::string>();
+  record.agent = j["agent"].get<std::string>();
+  record.timestamp = j["timestamp"].get<long long>();
+  record.hash = hash;
+  const std::filesystem::path rawHtmlDir =
+      std::filesystem::path(filePath).parent_path();
+  std::error_code ec;
+  const auto size =
+      std::filesystem::file_size(blobPathForHash(rawHtmlDir, hash), ec);
+  record.size = ec ? 0 : size;
+  appendManifestRecord(rawHtmlDir, record);
+
+  std::cout << "Saved raw HTML to: " << filePath << " (" << hash.substr(0, 12)
+            << ")\n";
+  return filePath;
+}
+
+std::string saveUnchangedMarker(const std::string &url, PropertyType propType,
+                                RealEstateAgent agent) {
   std::string filePath = HT::makeTimestampedFilename();
 
-  // 3) Save the raw HTML (plus any metadata) into a JSON file
+  // Same shape as a snapshot but without "html": the page answered 304, so
+  // the listings in its previous snapshot were still live at this time
   nlohmann::json j;
   j["url"] = url;
   j["type"] = PropertyManager::propertyTypeToString(propType);
   j["agent"] = PropertyManager::propertyAgentToString(agent);
-  j["timestamp"] = std::time(nullptr); // or store as string
-  j["html"] = html;
+  j["timestamp"] = std::time(nullptr);
+  j["unchanged"] = true;
 
   std::ofstream ofs(filePath);
   if (!ofs.is_open()) {
     std::cerr << "Error opening file: " << filePath << std::endl;
-    return html; // At least we have the HTML in memory
+    return "";
   }
-
   ofs << j.dump(4);
   ofs.close();
 
-  std::cout << "Saved raw HTML to: " << filePath << "\n";
-  return html;
+  SnapshotRecord record;
+  record.file = std::filesystem::path(filePath).filename().string();
+  record.url = url;
+  record.type = j["type"].get<std::string>();
+  record.agent = j["agent"].get<std::string>();
+  record.timestamp = j["timestamp"].get<long long>();
+  record.unchanged = true;
+  appendManifestRecord(std::filesystem::path(filePath).parent_path(), record);
+  return filePath;
+}
+
+std::string downloadAndSaveHtml(const std::string &url, PropertyType propType,
+                                RealEstateAgent agent) {
+  return fetchAndSaveOne({url, propType, agent, {}});
 }
 
 std::string cleanAsciiFilename(const std::string &filename) {
@@ -196,37 +168,124 @@ std::string getFilenameFromUrl(const std::string &url) {
   }
 }
 
-bool alreadyDownloaded(const std::string &filename) {
-  return std::filesystem::exists(filename);
-}
+namespace {
+
+// An image on its way to disk. The body goes to "<path>.part" and is only
+// renamed to its real name once the download completed, so an interrupted
+// run never leaves a truncated JPEG that later runs would treat as done.
+struct PendingImage {
+  std::string path;
+  std::string tmpPath;
+  std::ofstream ofs;
+  uint64_t bytes = 0;
+
+  bool write(const char *data, size_t size) {
+    if (!ofs.is_open()) {
+      ofs.open(tmpPath, std::ios::binary);
+      if (!ofs.is_open()) {
+        std::cerr << "Failed to open file for writing: " << tmpPath << "\n";
+        return false;
+      }
+    }
+    ofs.write(data, static_cast<std::streamsize>(size));
+    bytes += size;
+    return static_cast<bool>(ofs);
+  }
 
-void checkAndDownloadImages(const std::vector<Property> &allProperties) {
-  std::string imgFolder = "../src/raw_images/";
+  bool commit() {
+    ofs.close();
+    if (bytes == 0 || !ofs) {
+      discard();
+      return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+      std::cerr << "Error renaming " << tmpPath << ": " << ec.message() << "\n";
+      discard();
+      return false;
+    }
+    return true;
+  }
 
-  for (auto &prop : allProperties) {
-    // Suppose prop.img is the URL string
-    const std::string &imgUrl = prop.img;
-    if (imgUrl.empty()) {
-      continue; // no image
+  void discard() {
+    if (ofs.is_open()) {
+      ofs.close();
     }
+    std::error_code ec;
+    std::filesystem::remove(tmpPath, ec);
+  }
+};
 
-    // 1) Generate local filename
-    std::string filename = getFilenameFromUrl(imgUrl);
-    std::string fullImgName = prop.id;
-    std::string fullLocalPath = imgFolder + prop.id + "_" + filename;
+} // namespace
 
-    // 2) Check if file already exists
-    if (alreadyDownloaded(fullLocalPath)) {
-      continue; // skip
-    }
+void checkAndDownloadImages(const std::vector<Property> &allProperties,
+                            const FetchOptions &options) {
+  namespace fs = std::filesystem;
+  const std::string imgFolder = "../src/raw_images/";
+  std::error_code ec;
+  fs::create_directories(imgFolder, ec);
 
-    // 3) Download
-    if (!downloadToFile(imgUrl, fullLocalPath)) {
-      std::cerr << "Failed to download: " << imgUrl << "\n";
-    } else {
-      std::cout << "Downloaded: " << imgUrl << " => " << fullLocalPath << "\n";
+  // 1) List what is already on disk once, instead of one exists() per
+  //    property
+  std::unordered_set<std::string> existing;
+  for (const auto &entry : fs::directory_iterator(imgFolder, ec)) {
+    existing.insert(entry.path().filename().string());
+  }
+
+  // 2) Work out which images are missing; several listings (or several
+  //    snapshots of one listing) can point at the same file
+  std::vector<std::pair<std::string, std::string>> missing; // url, filename
+  std::unordered_set<std::string> queuedNames;
+  for (const auto &prop : allProperties) {
+    const std::string &imgUrl = prop.img;
+    if (imgUrl.empty()) {
+      continue; // no image
     }
+    std::string filename = prop.id + "_" + getFilenameFromUrl(imgUrl);
+    if (existing.count(filename) || !queuedNames.insert(filename).second) {
+      continue;
+    }
+    missing.emplace_back(imgUrl, std::move(filename));
+  }
+  if (missing.empty()) {
+    return;
   }
+  std::cout << "Downloading " << missing.size() << " missing images\n";
+
+  // 3) Fetch them concurrently, within the usual fetch limits
+  FetchEngine engine(options);
+  int downloaded = 0;
+  for (const auto &[imgUrl, filename] : missing) {
+    auto image = std::make_shared<PendingImage>();
+    image->path = imgFolder + filename;
+    image->tmpPath = image->path + ".part";
+
+    engine.add(
+        {imgUrl, PropertyType::Undefined, RealEstateAgent::Undefined, {}},
+        [image, &downloaded](FetchResult &result) {
+          const std::string &url = result.job.url;
+          if (!result.success || result.httpStatus != 200) {
+            image->discard();
+            std::cerr << "Failed to download: " << url << " (HTTP "
+                      << result.httpStatus << ")\n";
+            return;
+          }
+          if (!image->commit()) {
+            std::cerr << "Failed to download: " << url << "\n";
+            return;
+          }
+          ++downloaded;
+          std::cout << "Downloaded: " << url << " => " << image->path << "\n";
+        },
+        [image](const char *data, size_t size) {
+          return image->write(data, size);
+        });
+  }
+  engine.run();
+
+  std::cout << "Downloaded " << downloaded << " of " << missing.size()
+            << " images\n";
 }
 
 } // namespace HT
@@ -0,0 +1,605 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <scrapers/include/blobStore.hpp>
+#include <scrapers/include/deltaCodec.hpp>
+#include <scrapers/include/filesystem.hpp>
+#include <scrapers/include/hash.hpp>
+#include <scrapers/include/segmentLog.hpp>
+#include <scrapers/include/snapshotReader.hpp>
+
+namespace HT {
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kRecordMagic[4] = {'H', 'T', 'S', 'R'};
+const char kIndexMagic[8] = {'H', 'T', 'S', 'I', 'N', 'D', 'E', 'X'};
+constexpr uint64_t kHeaderSize = 16;  // magic, metadata size, body size
+constexpr uint64_t kTrailerSize = 24; // record count, index start, magic
+
+void putU32(std::string &out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+void putU64(std::string &out, uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint32_t getU32(const char *data) {
+  uint32_t value = 0;
+  for (int i = 3; i >= 0; --i) {
+    value = (value << 8) | static_cast<unsigned char>(data[i]);
+  }
+  return value;
+}
+
+uint64_t getU64(const char *data) {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; --i) {
+    value = (value << 8) | static_cast<unsigned char>(data[i]);
+  }
+  return value;
+}
+
+// Segment files in the order they were written
+std::vector<fs::path> segmentFiles(const std::string &dir) {
+  std::vector<fs::path> result;
+  std::error_code ec;
+  if (!fs::is_directory(dir, ec)) {
+    return result;
+  }
+  for (auto &entry : fs::directory_iterator(dir, ec)) {
+    const std::string name = entry.path().filename().string();
+    if (entry.is_regular_file() && name.rfind("segment-", 0) == 0 &&
+        entry.path().extension() == ".htseg") {
+      result.push_back(entry.path());
+    }
+  }
+  std::sort(result.begin(), result.end()); // numbers are zero-padded
+  return result;
+}
+
+int segmentNumber(const fs::path &segment) {
+  const std::string stem = segment.stem().string(); // segment-000012
+  try {
+    return std::stoi(stem.substr(stem.find('-') + 1));
+  } catch (...) {
+    return 0;
+  }
+}
+
+// Size of the well-formed record at offset, 0 if there is none
+uint64_t recordSpan(const char *data, uint64_t size, uint64_t offset) {
+  if (offset + kHeaderSize > size ||
+      std::memcmp(data + offset, kRecordMagic, 4) != 0) {
+    return 0;
+  }
+  const uint64_t metaSize = getU32(data + offset + 4);
+  const uint64_t bodySize = getU64(data + offset + 8);
+  if (metaSize > size || bodySize > size ||
+      offset + kHeaderSize + metaSize + bodySize > size) {
+    return 0;
+  }
+  return kHeaderSize + metaSize + bodySize;
+}
+
+// Record offsets of a segment. validEnd is where appending may resume: the
+// start of the footer, or the end of the last whole record.
+std::vector<uint64_t> segmentOffsets(const char *data, uint64_t size,
+                                     uint64_t &validEnd) {
+  std::vector<uint64_t> offsets;
+  if (size >= kTrailerSize &&
+      std::memcmp(data + size - 8, kIndexMagic, 8) == 0) {
+    const uint64_t count = getU64(data + size - kTrailerSize);
+    const uint64_t indexStart = getU64(data + size - 16);
+    if (count <= size / 8 && indexStart + count * 8 + kTrailerSize == size) {
+      for (uint64_t i = 0; i < count; ++i) {
+        offsets.push_back(getU64(data + indexStart + i * 8));
+      }
+      validEnd = indexStart;
+      return offsets;
+    }
+  }
+
+  // No footer: walk the records up to the first one that is cut short
+  uint64_t offset = 0;
+  while (const uint64_t span = recordSpan(data, size, offset)) {
+    offsets.push_back(offset);
+    offset += span;
+  }
+  validEnd = offset;
+  return offsets;
+}
+
+// Where the body of a record is, and how to read it
+struct RecordBody {
+  uint64_t start = 0;
+  uint64_t size = 0; // 0 when the record has no body of its own
+  bool delta = false;
+  std::string baseSegment; // record the delta applies to
+  uint64_t baseOffset = 0;
+};
+
+// Fills record from the record at offset of a mapped segment
+bool parseRecord(const char *data, uint64_t size, const fs::path &segment,
+                 uint64_t offset, SnapshotRecord &record, RecordBody &body) {
+  if (recordSpan(data, size, offset) == 0) {
+    return false;
+  }
+  const uint64_t metaSize = getU32(data + offset + 4);
+  body = RecordBody{};
+  body.size = getU64(data + offset + 8);
+  body.start = offset + kHeaderSize + metaSize;
+
+  const char *meta = data + offset + kHeaderSize;
+  nlohmann::json j = nlohmann::json::parse(meta, meta + metaSize, nullptr,
+                                           false);
+  if (j.is_discarded() || !j.is_object()) {
+    return false;
+  }
+  record = SnapshotRecord{};
+  record.file = j.value("file", "");
+  record.url = j.value("url", "");
+  record.type = j.value("type", "");
+  record.agent = j.value("agent", "");
+  record.timestamp = j.value("timestamp", 0LL);
+  record.hash = j.value("hash", "");
+  record.unchanged = j.value("unchanged", false);
+  record.size = j.value("size", uint64_t{0});
+  if (j.contains("bodySegment")) {
+    record.segment =
+        (segment.parent_path() / j.value("bodySegment", "")).string();
+    record.offset = j.value("bodyOffset", uint64_t{0});
+  } else {
+    record.segment = segment.string();
+    record.offset = offset;
+  }
+  if (j.value("delta", false)) {
+    body.delta = true;
+    body.baseSegment =
+        (segment.parent_path() / j.value("baseSegment", "")).string();
+    body.baseOffset = j.value("baseOffset", uint64_t{0});
+  }
+  return true;
+}
+
+// Pages rebuilt from deltas, kept so that the next version of the same url
+// does not replay its chain from the keyframe again. Ingest reads the
+// versions of a url in order, so the most recent few are enough.
+class PageCache {
+public:
+  std::shared_ptr<const std::string> find(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &slot : slots) {
+      if (slot.first == key) {
+        return slot.second;
+      }
+    }
+    return nullptr;
+  }
+
+  void insert(std::string key, std::shared_ptr<const std::string> page) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (slots.size() < kSlots) {
+      slots.emplace_back(std::move(key), std::move(page));
+      return;
+    }
+    slots[next] = {std::move(key), std::move(page)};
+    next = (next + 1) % kSlots;
+  }
+
+private:
+  static constexpr size_t kSlots = 64;
+  std::mutex mutex;
+  std::vector<std::pair<std::string, std::shared_ptr<const std::string>>>
+      slots;
+  size_t next = 0;
+};
+
+PageCache &pageCache() {
+  static PageCache cache;
+  return cache;
+}
+
+// The page of the record holding a body, rebuilding it if it is a delta
+std::shared_ptr<const std::string> readPage(const std::string &segment,
+                                            uint64_t offset) {
+  const std::string key = segment + "|" + std::to_string(offset);
+  if (auto page = pageCache().find(key)) {
+    return page;
+  }
+  SnapshotRecord record;
+  std::string body;
+  if (!readSegmentRecord(segment, offset, record, &body)) {
+    return nullptr;
+  }
+  auto page = std::make_shared<const std::string>(std::move(body));
+  pageCache().insert(key, page);
+  return page;
+}
+
+// Writes an html_*.json entry for a record under its original name
+bool writeEntry(const std::string &rawHtmlDir, const SnapshotRecord &record) {
+  nlohmann::json j;
+  j["url"] = record.url;
+  j["type"] = record.type;
+  j["agent"] = record.agent;
+  j["timestamp"] = record.timestamp;
+  if (record.unchanged) {
+    j["unchanged"] = true;
+  } else {
+    j["hash"] = record.hash;
+  }
+
+  const fs::path path = fs::path(rawHtmlDir) / record.file;
+  std::ofstream ofs(path);
+  if (!ofs.is_open()) {
+    std::cerr << "Error opening file: " << path << std::endl;
+    return false;
+  }
+  ofs << j.dump(4);
+  return static_cast<bool>(ofs);
+}
+
+} // namespace
+
+SegmentLog::SegmentLog(std::string dir, uint64_t segmentBytes,
+                       int keyframeInterval)
+    : dir(std::move(dir)), segmentBytes(segmentBytes),
+      keyframeInterval(keyframeInterval) {
+  load();
+}
+
+SegmentLog::~SegmentLog() { seal(); }
+
+void SegmentLog::load() {
+  for (const auto &record : readSegmentRecords(dir)) {
+    files.insert(record.file);
+    if (!record.unchanged) {
+      bodyByHash.emplace(record.hash, record);
+    }
+  }
+
+  const std::vector<fs::path> segments = segmentFiles(dir);
+  if (!segments.empty()) {
+    nextSegment = segmentNumber(segments.back()) + 1;
+    std::error_code ec;
+    if (fs::file_size(segments.back(), ec) < segmentBytes && !ec) {
+      reopenPath = segments.back().string();
+    }
+  }
+}
+
+bool SegmentLog::contains(const std::string &file) const {
+  return files.count(file) > 0;
+}
+
+bool SegmentLog::openSegment() {
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+
+  if (!reopenPath.empty()) {
+    // Continue the last segment: drop its footer (or a torn last record)
+    // and append after its records
+    uint64_t validEnd = 0;
+    {
+      MappedFile file(reopenPath);
+      if (!file.isOpen()) {
+        std::cerr << "Error opening file: " << reopenPath << std::endl;
+        return false;
+      }
+      offsets = segmentOffsets(file.data(), file.size(), validEnd);
+    }
+    fs::resize_file(reopenPath, validEnd, ec);
+    if (ec) {
+      std::cerr << "Error truncating " << reopenPath << ": " << ec.message()
+                << "\n";
+      return false;
+    }
+    segmentPath = reopenPath;
+    segmentSize = validEnd;
+    reopenPath.clear();
+  } else {
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%06d.htseg", nextSegment++);
+    segmentPath = (fs::path(dir) / name).string();
+    segmentSize = 0;
+    offsets.clear();
+  }
+
+  ofs.open(segmentPath, std::ios::binary | std::ios::app);
+  if (!ofs.is_open()) {
+    std::cerr << "Error opening file: " << segmentPath << std::endl;
+    segmentPath.clear();
+    return false;
+  }
+  return true;
+}
+
+bool SegmentLog::append(const SnapshotRecord &record, std::string_view body) {
+  if (contains(record.file)) {
+    return true;
+  }
+  if (segmentPath.empty() && !openSegment()) {
+    return false;
+  }
+
+  nlohmann::json meta;
+  meta["file"] = record.file;
+  meta["url"] = record.url;
+  meta["type"] = record.type;
+  meta["agent"] = record.agent;
+  meta["timestamp"] = record.timestamp;
+  bool storeBody = false;
+  int depth = 0;
+  std::string delta;
+  const std::string_view page = body;
+  if (record.unchanged) {
+    meta["unchanged"] = true;
+    body = {};
+  } else {
+    meta["hash"] = record.hash;
+    meta["size"] = body.size();
+    auto holder = bodyByHash.find(record.hash);
+    if (holder != bodyByHash.end()) {
+      meta["bodySegment"] =
+          fs::path(holder->second.segment).filename().string();
+      meta["bodyOffset"] = holder->second.offset;
+      body = {};
+    } else {
+      storeBody = true;
+      // A page that changed a little since the previous version of its url
+      // is stored as a delta against it, with a keyframe every
+      // keyframeInterval versions to bound the chain a read has to replay
+      auto tip = tipByUrl.find(record.url);
+      if (tip != tipByUrl.end() && tip->second.depth + 1 < keyframeInterval) {
+        delta = encodeDelta(tip->second.page, body);
+        if (delta.size() < body.size() / 2) {
+          depth = tip->second.depth + 1;
+          meta["delta"] = true;
+          meta["baseSegment"] =
+              fs::path(tip->second.segment).filename().string();
+          meta["baseOffset"] = tip->second.offset;
+          meta["depth"] = depth;
+          body = delta;
+        }
+      }
+    }
+  }
+
+  const std::string metaText = meta.dump();
+  std::string header(kRecordMagic, 4);
+  putU32(header, static_cast<uint32_t>(metaText.size()));
+  putU64(header, body.size());
+
+  const uint64_t offset = segmentSize;
+  ofs.write(header.data(), static_cast<std::streamsize>(header.size()));
+  ofs.write(metaText.data(), static_cast<std::streamsize>(metaText.size()));
+  ofs.write(body.data(), static_cast<std::streamsize>(body.size()));
+  if (!ofs) {
+    std::cerr << "Error writing file: " << segmentPath << std::endl;
+    return false;
+  }
+  segmentSize += header.size() + metaText.size() + body.size();
+  offsets.push_back(offset);
+  files.insert(record.file);
+
+  if (storeBody) {
+    SnapshotRecord holder = record;
+    holder.segment = segmentPath;
+    holder.offset = offset;
+    bodyByHash.emplace(record.hash, std::move(holder));
+    UrlTip &tip = tipByUrl[record.url];
+    tip.segment = segmentPath;
+    tip.offset = offset;
+    tip.depth = depth;
+    tip.page.assign(page.data(), page.size());
+  }
+
+  if (segmentSize >= segmentBytes) {
+    return seal();
+  }
+  return true;
+}
+
+bool SegmentLog::seal() {
+  if (segmentPath.empty()) {
+    return true;
+  }
+
+  std::string footer;
+  footer.reserve(offsets.size() * 8 + kTrailerSize);
+  for (uint64_t offset : offsets) {
+    putU64(footer, offset);
+  }
+  putU64(footer, offsets.size());
+  putU64(footer, segmentSize);
+  footer.append(kIndexMagic, 8);
+
+  ofs.write(footer.data(), static_cast<std::streamsize>(footer.size()));
+  ofs.close();
+  const bool ok = static_cast<bool>(ofs);
+  if (!ok) {
+    std::cerr << "Error writing file: " << segmentPath << std::endl;
+  }
+  segmentPath.clear();
+  segmentSize = 0;
+  offsets.clear();
+  return ok;
+}
+
+std::vector<SnapshotRecord> readSegmentRecords(const std::string &dir) {
+  std::vector<SnapshotRecord> records;
+  for (const auto &segment : segmentFiles(dir)) {
+    MappedFile file(segment);
+    if (!file.isOpen()) {
+      std::cerr << "Error opening file: " << segment << std::endl;
+      continue;
+    }
+    uint64_t validEnd = 0;
+    for (uint64_t offset :
+         segmentOffsets(file.data(), file.size(), validEnd)) {
+      SnapshotRecord record;
+      RecordBody body;
+      if (parseRecord(file.data(), file.size(), segment, offset, record,
+                      body)) {
+        records.push_back(std::move(record));
+      }
+    }
+  }
+  return records;
+}
+
+bool readSegmentRecord(const std::string &segment, uint64_t offset,
+                       SnapshotRecord &record, std::string *body) {
+  MappedFile file(segment);
+  if (!file.isOpen()) {
+    return false;
+  }
+  RecordBody stored;
+  if (!parseRecord(file.data(), file.size(), segment, offset, record,
+                   stored)) {
+    return false;
+  }
+  if (!body) {
+    return true;
+  }
+  if (stored.size == 0 && !record.unchanged &&
+      (record.segment != segment || record.offset != offset)) {
+    // The page is stored with an earlier record of the same content
+    auto page = readPage(record.segment, record.offset);
+    if (!page) {
+      return false;
+    }
+    body->assign(*page);
+    return true;
+  }
+  const std::string_view bytes(file.data() + stored.start,
+                               static_cast<size_t>(stored.size));
+  if (stored.delta) {
+    auto base = readPage(stored.baseSegment, stored.baseOffset);
+    return base && applyDelta(*base, bytes, *body);
+  }
+  body->assign(bytes.data(), bytes.size());
+  return true;
+}
+
+int importSnapshotsToSegments(const std::string &rawHtmlDir) {
+  const std::vector<SnapshotRecord> records =
+      snapshotRecordsFor(rawHtmlDir, gatherJsonFiles(rawHtmlDir));
+
+  std::unordered_map<std::string, size_t> newestByUrl;
+  for (size_t i = 0; i < records.size(); ++i) {
+    if (records[i].unchanged) {
+      continue;
+    }
+    auto it = newestByUrl.find(records[i].url);
+    if (it == newestByUrl.end() ||
+        records[i].timestamp >= records[it->second].timestamp) {
+      newestByUrl[records[i].url] = i;
+    }
+  }
+
+  SegmentLog log(rawHtmlDir + "/segments");
+  std::vector<bool> moved(records.size(), false);
+  std::string body;
+  for (size_t i = 0; i < records.size(); ++i) {
+    const SnapshotRecord &record = records[i];
+    if (!record.unchanged && newestByUrl[record.url] == i) {
+      continue;
+    }
+    if (!log.contains(record.file)) {
+      body.clear();
+      if (!record.unchanged) {
+        SnapshotFields fields;
+        if (record.inlineHtml) {
+          readSnapshotFile(fs::path(rawHtmlDir) / record.file, fields, body);
+        } else {
+          loadBlob(rawHtmlDir, record.hash, body);
+        }
+        if (sha256Hex(body) != record.hash) {
+          std::cerr << "Skipping " << record.file
+                    << ": its page does not match its hash\n";
+          continue;
+        }
+      }
+      if (!log.append(record, body)) {
+        break;
+      }
+    }
+    moved[i] = true;
+  }
+  // Nothing is deleted before the segment is complete on disk
+  if (!log.seal()) {
+    return -1;
+  }
+
+  std::unordered_set<std::string> keptHashes;
+  for (size_t i = 0; i < records.size(); ++i) {
+    if (!moved[i]) {
+      keptHashes.insert(records[i].hash);
+    }
+  }
+  int count = 0;
+  for (size_t i = 0; i < records.size(); ++i) {
+    if (!moved[i]) {
+      continue;
+    }
+    const SnapshotRecord &record = records[i];
+    std::error_code ec;
+    fs::remove(fs::path(rawHtmlDir) / record.file, ec);
+    if (!record.unchanged && !record.inlineHtml &&
+        keptHashes.count(record.hash) == 0) {
+      fs::remove(blobPathForHash(rawHtmlDir, record.hash), ec);
+    }
+    ++count;
+  }
+
+  std::cout << "Moved " << count << " snapshots into " << rawHtmlDir
+            << "/segments\n";
+  if (count > 0) {
+    rebuildManifest(rawHtmlDir); // drops the moved entries
+  }
+  return count;
+}
+
+int exportSegmentsToSnapshots(const std::string &rawHtmlDir) {
+  int count = 0;
+  std::string body;
+  for (SnapshotRecord record : readSegmentRecords(rawHtmlDir + "/segments")) {
+    std::error_code ec;
+    if (fs::exists(fs::path(rawHtmlDir) / record.file, ec)) {
+      continue;
+    }
+    if (!record.unchanged) {
+      SnapshotRecord holder;
+      if (!readSegmentRecord(record.segment, record.offset, holder, &body) ||
+          storeBlob(rawHtmlDir, body) != record.hash) {
+        std::cerr << "Skipping " << record.file
+                  << ": its page could not be restored\n";
+        continue;
+      }
+    }
+    if (!writeEntry(rawHtmlDir, record)) {
+      continue;
+    }
+    record.segment.clear();
+    record.offset = 0;
+    appendManifestRecord(rawHtmlDir, record);
+    ++count;
+  }
+  std::cout << "Exported " << count << " snapshots to " << rawHtmlDir << "\n";
+  return count;
+}
+
+} // namespace HT
@@ -1,20 +0,0 @@
-// skynModel.hpp
-#pragma once
-#include <string>
-
-struct SkynProperty {
-  std::string id;
-  std::string website;
-  std::string type;
-  std::string ogn_headline;
-  std::string ogn_address;
-  std::string prop_size;
-  std::string prop_ground_size;
-  std::string prop_bedrooms;
-  std::string prop_floors;
-  std::string prop_buildYear;
-  std::string prop_listPrice;
-  std::string prop_latestOffer;
-  std::string prop_validToDate;
-  std::string img;
-};
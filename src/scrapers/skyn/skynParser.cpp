@@ -1,112 +1,53 @@
-
 #include <cstring>
 #include <gumbo.h>
-#include <regex>
 #include <scrapers/include/PropertyManager.hpp>
+#include <scrapers/include/cardExtractor.hpp>
+#include <scrapers/include/gumboArena.hpp>
 #include <scrapers/include/house_model.hpp>
 #include <scrapers/include/parser.hpp>
-#include <scrapers/skyn/skynModel.hpp>
-#include <scrapers/skyn/skynScraper.hpp>
+#include <scrapers/include/tagScanner.hpp>
+#include <scrapers/include/textScan.hpp>
+#include <scrapers/skyn/skynParser.hpp>
 
 namespace HT::SKYN {
-
-bool hasExactClass(const char *classAttr, const std::string &targetClass) {
-  if (!classAttr)
-    return false;
-  std::istringstream iss(classAttr);
-  std::string token;
-  while (iss >> token) {
-    if (token == targetClass)
-      return true;
-  }
-  return false;
-}
-
-void parseSkynProperty(GumboNode *node, SkynProperty *p) {
-  if (!node || node->type != GUMBO_NODE_ELEMENT)
-    return;
-
-  const char *classAttr = getClassAttr(node);
-  std::string cls = classAttr ? classAttr : "";
-
-  /* ---------- 1. pick up the picture wherever it is -------------- */
-  if (node->v.element.tag == GUMBO_TAG_IMG) {
-    const char *src = getAttribute(&node->v.element.attributes, "src");
-    if (src && strstr(src, "/admin/public/getimage") != nullptr) {
-      std::string imgstring = static_cast<std::string>(src);
-      p->img = "https://www.skyn.fo" + imgstring; // absolute URL already
-    }
-  }
-
-  /* ---------- 2. the ordinary class‑based fields ----------------- */
-  if (!cls.empty()) {
-    if (cls.find("ogn_headline") != std::string::npos)
-      p->ogn_headline = getNodeText(node);
-    else if (cls.find("ogn_adress") != std::string::npos)
-      p->ogn_address = getNodeText(node);
-    else if (cls.find("prop-size") != std::string::npos)
-      p->prop_size = getNodeText(node->parent);
-    else if (cls.find("prop-ground") != std::string::npos)
-      p->prop_ground_size = getNodeText(node->parent);
-    else if (cls.find("prop-bedrooms") != std::string::npos)
-      p->prop_bedrooms = getNodeText(node->parent);
-    else if (cls.find("prop-floors") != std::string::npos)
-      p->prop_floors = getNodeText(node->parent);
-    else if (cls.find("prop-buildyear") != std::string::npos)
-      p->prop_buildYear = getNodeText(node->parent);
-    else if (hasExactClass(classAttr, "latestoffer"))
-      p->prop_latestOffer = getNodeText(node);
-    else if (cls.find("validto") != std::string::npos)
-      p->prop_validToDate = getNodeText(node);
-    else if (hasExactClass(classAttr, "listprice"))
-      p->prop_listPrice = getNodeText(node);
-  }
-
-  /* 3. recurse */
-  GumboVector *ch = &node->v.element.children;
-  for (unsigned int i = 0; i < ch->length; ++i)
-    parseSkynProperty(static_cast<GumboNode *>(ch->data[i]), p);
-}
-
-std::vector<RawProperty>
-mapBetriToRawProperty(std::vector<RawProperty> &rawProperties,
-                      std::vector<SkynProperty> &skynProperties,
-                      PropertyType propType) {
-  for (auto &sp : skynProperties) {
-    RawProperty rp;
-    sp.type = PropertyManager::propertyTypeToString(propType);
-    sp.id = PropertyManager::cleanId(sp.ogn_headline + sp.ogn_address);
-
-    rp.id = sp.id;
-    rp.website = sp.website;
-    rp.address = sp.ogn_headline;
-    rp.type = sp.type;
-    rp.city = sp.ogn_address;
-    rp.price = sp.prop_listPrice;
-    rp.latestOffer = sp.prop_latestOffer;
-    rp.validDate = sp.prop_validToDate;
-    rp.buildingSize = sp.prop_size;
-    rp.landSize = sp.prop_ground_size;
-    rp.room = sp.prop_bedrooms;
-    rp.floor = sp.prop_floors;
-    rp.img = sp.img;
-    rp.agent = PropertyManager::propertyAgentToString(RealEstateAgent::Skyn);
-    rawProperties.push_back(rp);
-  }
-  return rawProperties;
+namespace {
+
+// The fields of an "ogn" card, in the order the old hand-written visitor
+// tried them. The sizes, rooms and floors are labels next to an icon that
+// carries the class, so they come from the icon's parent.
+const CardExtractor &skynCard() {
+  static const CardExtractor extractor(CardSpec{
+      {
+          {"ogn_headline", ClassMatch::Substring, FieldSource::Text,
+           &RawProperty::address},
+          {"ogn_adress", ClassMatch::Substring, FieldSource::Text,
+           &RawProperty::city},
+          {"prop-size", ClassMatch::Substring, FieldSource::ParentText,
+           &RawProperty::buildingSize},
+          {"prop-ground", ClassMatch::Substring, FieldSource::ParentText,
+           &RawProperty::landSize},
+          {"prop-bedrooms", ClassMatch::Substring, FieldSource::ParentText,
+           &RawProperty::room},
+          {"prop-floors", ClassMatch::Substring, FieldSource::ParentText,
+           &RawProperty::floor},
+          {"latestoffer", ClassMatch::Token, FieldSource::Text,
+           &RawProperty::latestOffer},
+          {"validto", ClassMatch::Substring, FieldSource::Text,
+           &RawProperty::validDate},
+          {"listprice", ClassMatch::Token, FieldSource::Text,
+           &RawProperty::price},
+      },
+      // The picture, wherever it is in the card
+      ImageSpec{GUMBO_TAG_IMG, nullptr, nullptr, nullptr,
+                "/admin/public/getimage", "https://www.skyn.fo", false},
+  });
+  return extractor;
 }
 
-// helper: true if the class attribute contains the *word* "ogn"
-// (not just the substring)
-static bool classHasWordOgn(const char *cls) {
-  if (!cls)
-    return false;
-  // word boundaries: start/end or whitespace around "ogn"
-  static const std::regex re(R"((^|\s)ogn(\s|$))");
-  return std::regex_search(cls, re);
-}
+} // namespace
 
-void findSkynProperties(GumboNode *node, std::vector<SkynProperty> &results) {
+void findSkynProperties(GumboNode *node, std::vector<RawProperty> &results,
+                        PropertyType propType) {
   if (!node || node->type != GUMBO_NODE_ELEMENT)
     return;
 
@@ -127,19 +68,19 @@ void findSkynProperties(GumboNode *node, std::vector<SkynProperty> &results) {
         continue;
 
       const char *childCls = getClassAttr(child);
-      if (!classHasWordOgn(childCls))
+      if (!childCls || !hasWord(childCls, "ogn"))
         continue; // not a property card
 
       /* ---------------------------------------------------
          2. parse one property card
          --------------------------------------------------- */
-      SkynProperty prop;
+      RawProperty &prop = results.emplace_back();
+      skynCard().extract(child, prop);
       prop.website = "Skyn";
-
-      parseSkynProperty(child, &prop);
-
-      prop.id = PropertyManager::cleanId(prop.ogn_headline + prop.ogn_address);
-      results.push_back(std::move(prop));
+      prop.type = PropertyManager::propertyTypeToString(propType);
+      prop.id = PropertyManager::cleanId(prop.address + prop.city);
+      prop.agent =
+          PropertyManager::propertyAgentToString(RealEstateAgent::Skyn);
     }
     return; // we’ve handled all properties; no recursion
   }
@@ -149,18 +90,40 @@ void findSkynProperties(GumboNode *node, std::vector<SkynProperty> &results) {
      ------------------------------------------------------------ */
   GumboVector *kids = &node->v.element.children;
   for (unsigned i = 0; i < kids->length; ++i)
-    findSkynProperties(static_cast<GumboNode *>(kids->data[i]), results);
+    findSkynProperties(static_cast<GumboNode *>(kids->data[i]), results,
+                       propType);
+}
+
+bool isSkynList(const char *classAttr) {
+  return classAttr && std::strstr(classAttr, "ognlist") != nullptr;
 }
 
-std::vector<RawProperty> parseWithGumboSkyn(std::string html,
+bool scanSkynPage(const std::string &html, PropertyType propType,
+                  std::vector<RawProperty> &out) {
+  const bool scanned = scanElements(html, isSkynList, [&](GumboNode *list) {
+    findSkynProperties(list, out, propType);
+  });
+  if (!scanned) {
+    out.clear();
+  }
+  return scanned;
+}
+
+std::vector<RawProperty> parseSkynWithGumbo(const std::string &html,
                                             PropertyType propType) {
-  std::vector<SkynProperty> props;
   std::vector<RawProperty> rawProps;
-  GumboOutput *output = gumbo_parse(html.c_str());
-  findSkynProperties(output->root, props);
-  gumbo_destroy_output(&kGumboDefaultOptions, output);
-  mapBetriToRawProperty(rawProps, props, propType);
+  GumboDocument document(html);
+  findSkynProperties(document.root(), rawProps, propType);
   return rawProps;
 }
 
+std::vector<RawProperty> parseWithGumboSkyn(const std::string &html,
+                                            PropertyType propType) {
+  std::vector<RawProperty> rawProps;
+  if (tagScannerEnabled() && scanSkynPage(html, propType, rawProps)) {
+    return rawProps;
+  }
+  return parseSkynWithGumbo(html, propType);
+}
+
 } // namespace HT::SKYN
@@ -2,7 +2,21 @@
 #include <scrapers/include/house_model.hpp>
 namespace HT::SKYN {
 
-std::vector<RawProperty> parseWithGumboSkyn(std::string html,
+// Bump when the parser output changes (see parseCache.hpp)
+constexpr int kParserVersion = 2;
+
+// Reads the listings with Gumbo, or with the tag scanner first when it is on
+std::vector<RawProperty> parseWithGumboSkyn(const std::string &html,
+                                            PropertyType propType);
+
+// The class of the <div> that holds the listings
+bool isSkynList(const char *classAttr);
+
+// The two ways parseWithGumboSkyn reads a page; scanSkynPage leaves out
+// empty and returns false when the page has to go to Gumbo
+bool scanSkynPage(const std::string &html, PropertyType propType,
+                  std::vector<RawProperty> &out);
+std::vector<RawProperty> parseSkynWithGumbo(const std::string &html,
                                             PropertyType propType);
 
 }
@@ -1,5 +1,7 @@
 #pragma once
+#include <scrapers/include/fetchEngine.hpp>
 namespace HT {
 
-int skynRun(bool downloadNewHtml);
+std::vector<FetchJob> skynJobs();
+int skynRun(bool downloadNewHtml, const FetchOptions &options = {});
 }
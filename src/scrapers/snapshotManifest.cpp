@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <scrapers/include/blobStore.hpp>
+#include <scrapers/include/filesystem.hpp>
+#include <scrapers/include/hash.hpp>
+#include <scrapers/include/segmentLog.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
+#include <scrapers/include/snapshotReader.hpp>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace HT {
+namespace fs = std::filesystem;
+
+// The manifest sits next to the entries it describes
+static fs::path manifestPath(const fs::path &rawHtmlDir) {
+  return rawHtmlDir / "manifest.jsonl";
+}
+
+static nlohmann::json recordToJson(const SnapshotRecord &record) {
+  nlohmann::json j;
+  j["file"] = record.file;
+  j["url"] = record.url;
+  j["type"] = record.type;
+  j["agent"] = record.agent;
+  j["timestamp"] = record.timestamp;
+  j["size"] = record.size;
+  j["hash"] = record.hash;
+  if (record.unchanged) {
+    j["unchanged"] = true;
+  }
+  if (record.inlineHtml) {
+    j["inline"] = true;
+  }
+  return j;
+}
+
+static bool recordFromJson(const nlohmann::json &j, SnapshotRecord &record) {
+  if (!j.is_object() || !j.contains("file") || !j.contains("url")) {
+    return false;
+  }
+  record.file = j.value("file", "");
+  record.url = j.value("url", "");
+  record.type = j.value("type", "");
+  record.agent = j.value("agent", "");
+  record.timestamp = j.value("timestamp", 0LL);
+  record.size = j.value("size", uint64_t{0});
+  record.hash = j.value("hash", "");
+  record.unchanged = j.value("unchanged", false);
+  record.inlineHtml = j.value("inline", false);
+  return !record.file.empty();
+}
+
+static std::unordered_map<std::string, SnapshotRecord>
+loadManifest(const fs::path &rawHtmlDir) {
+  std::unordered_map<std::string, SnapshotRecord> records;
+  std::ifstream ifs(manifestPath(rawHtmlDir));
+  std::string line;
+  while (std::getline(ifs, line)) {
+    // A run that died mid-append leaves at most one broken last line
+    nlohmann::json j = nlohmann::json::parse(line, nullptr, false);
+    SnapshotRecord record;
+    if (!j.is_discarded() && recordFromJson(j, record)) {
+      records[record.file] = std::move(record);
+    }
+  }
+  return records;
+}
+
+bool appendManifestRecord(const fs::path &rawHtmlDir,
+                          const SnapshotRecord &record) {
+  static std::mutex appendMutex;
+  std::lock_guard<std::mutex> lock(appendMutex);
+
+  const fs::path path = manifestPath(rawHtmlDir);
+  std::ofstream ofs(path, std::ios::app);
+  if (!ofs.is_open()) {
+    std::cerr << "Error opening file: " << path << std::endl;
+    return false;
+  }
+  ofs << recordToJson(record).dump() << "\n";
+  return static_cast<bool>(ofs);
+}
+
+bool readSnapshotRecord(const fs::path &entryFile, SnapshotRecord &record) {
+  // An embedded page is hashed as it is unescaped, never held as a whole
+  Sha256 sha;
+  uint64_t htmlSize = 0;
+  SnapshotFields fields;
+  if (!readSnapshotFile(entryFile, fields,
+                        [&sha, &htmlSize](const char *data, size_t size) {
+                          sha.update(data, size);
+                          htmlSize += size;
+                          return true;
+                        }) ||
+      fields.url.empty()) {
+    return false;
+  }
+
+  record = SnapshotRecord{};
+  record.file = entryFile.filename().string();
+  record.url = std::move(fields.url);
+  record.type = std::move(fields.type);
+  record.agent = std::move(fields.agent);
+  record.timestamp = fields.timestamp;
+  record.unchanged = fields.unchanged;
+  if (record.unchanged) {
+    return true;
+  }
+
+  if (!fields.hash.empty()) {
+    record.hash = std::move(fields.hash);
+    std::error_code ec;
+    const auto size = fs::file_size(
+        blobPathForHash(entryFile.parent_path(), record.hash), ec);
+    record.size = ec ? 0 : size;
+  } else {
+    record.hash = sha.hexDigest();
+    record.size = htmlSize;
+    record.inlineHtml = true;
+  }
+  return true;
+}
+
+std::vector<SnapshotRecord>
+snapshotRecordsFor(const fs::path &rawHtmlDir,
+                   const std::vector<fs::path> &entryFiles) {
+  std::unordered_map<std::string, SnapshotRecord> known =
+      loadManifest(rawHtmlDir);
+
+  std::vector<SnapshotRecord> records;
+  records.reserve(entryFiles.size());
+  int added = 0;
+  for (const auto &path : entryFiles) {
+    auto it = known.find(path.filename().string());
+    if (it != known.end()) {
+      records.push_back(it->second);
+      continue;
+    }
+
+    SnapshotRecord record;
+    if (!readSnapshotRecord(path, record)) {
+      continue;
+    }
+    appendManifestRecord(rawHtmlDir, record);
+    records.push_back(std::move(record));
+    ++added;
+  }
+
+  if (added > 0) {
+    std::cout << "Added " << added << " snapshots to the manifest\n";
+  }
+  return records;
+}
+
+std::vector<SnapshotRecord>
+archivedSnapshotRecords(const std::string &rawHtmlDir) {
+  std::vector<SnapshotRecord> records =
+      snapshotRecordsFor(rawHtmlDir, gatherJsonFiles(rawHtmlDir));
+  std::unordered_set<std::string> entryFiles;
+  for (const auto &record : records) {
+    entryFiles.insert(record.file);
+  }
+  for (auto &record : readSegmentRecords(rawHtmlDir + "/segments")) {
+    if (entryFiles.count(record.file) == 0) {
+      records.push_back(std::move(record));
+    }
+  }
+  std::stable_sort(records.begin(), records.end(),
+                   [](const SnapshotRecord &a, const SnapshotRecord &b) {
+                     return a.file < b.file;
+                   });
+  return records;
+}
+
+bool loadSnapshotPage(const fs::path &rawHtmlDir, const SnapshotRecord &record,
+                      std::string &html) {
+  html.clear();
+  if (!record.segment.empty()) {
+    SnapshotRecord holder;
+    return readSegmentRecord(record.segment, record.offset, holder, &html) &&
+           !html.empty();
+  }
+  if (!record.inlineHtml) {
+    loadBlob(rawHtmlDir, record.hash, html);
+    return !html.empty();
+  }
+
+  SnapshotFields fields;
+  if (!readSnapshotFile(rawHtmlDir / record.file, fields, html)) {
+    return false;
+  }
+  if (!fields.hasHtml && !fields.hash.empty()) {
+    loadBlob(rawHtmlDir, fields.hash, html); // migrated since
+  }
+  return !html.empty();
+}
+
+int rebuildManifest(const std::string &rawHtmlDir) {
+  const fs::path path = manifestPath(rawHtmlDir);
+  const fs::path tmpPath = path.string() + ".tmp";
+  int written = 0;
+  {
+    std::ofstream ofs(tmpPath);
+    if (!ofs.is_open()) {
+      std::cerr << "Error opening file: " << tmpPath << std::endl;
+      return -1;
+    }
+    for (const auto &path : gatherJsonFiles(rawHtmlDir)) {
+      SnapshotRecord record;
+      if (!readSnapshotRecord(path, record)) {
+        std::cerr << "Skipping unreadable " << path << "\n";
+        continue;
+      }
+      ofs << recordToJson(record).dump() << "\n";
+      ++written;
+    }
+    if (!ofs) {
+      std::cerr << "Error writing file: " << tmpPath << std::endl;
+      return -1;
+    }
+  }
+
+  std::error_code ec;
+  fs::rename(tmpPath, path, ec);
+  if (ec) {
+    std::cerr << "Error renaming " << tmpPath << ": " << ec.message() << "\n";
+    return -1;
+  }
+  std::cout << "Rebuilt the manifest with " << written << " snapshots\n";
+  return written;
+}
+
+} // namespace HT
@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <nlohmann/json.hpp>
+#include <scrapers/include/snapshotReader.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HT {
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path &path) {
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return;
+  }
+  fileHandle = file;
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize)) {
+    return;
+  }
+  open = true;
+  if (fileSize.QuadPart == 0) {
+    return; // an empty file cannot be mapped, and needs no mapping
+  }
+
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    open = false;
+    return;
+  }
+  mappingHandle = mapping;
+  mapped = static_cast<const char *>(
+      MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!mapped) {
+    open = false;
+    return;
+  }
+  length = static_cast<size_t>(fileSize.QuadPart);
+}
+
+MappedFile::~MappedFile() {
+  if (mapped) {
+    UnmapViewOfFile(mapped);
+  }
+  if (mappingHandle) {
+    CloseHandle(mappingHandle);
+  }
+  if (fileHandle) {
+    CloseHandle(fileHandle);
+  }
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path &path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return;
+  }
+  open = true;
+  if (st.st_size > 0) {
+    void *address = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                         MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+      open = false;
+    } else {
+      mapped = static_cast<const char *>(address);
+      length = static_cast<size_t>(st.st_size);
+      // Read front to back exactly once
+      madvise(address, length, MADV_SEQUENTIAL);
+    }
+  }
+  ::close(fd); // the mapping keeps the file alive
+}
+
+MappedFile::~MappedFile() {
+  if (mapped) {
+    munmap(const_cast<char *>(mapped), length);
+  }
+}
+#endif
+
+namespace {
+
+// Picks the top-level scalars out of an entry's metadata; anything nested
+// is skipped
+class SnapshotFieldsSax : public nlohmann::json_sax<nlohmann::json> {
+public:
+  explicit SnapshotFieldsSax(SnapshotFields &fields) : fields(fields) {}
+
+  bool null() override { return true; }
+  bool boolean(bool value) override {
+    if (atTop() && currentKey == "unchanged") {
+      fields.unchanged = value;
+    }
+    return true;
+  }
+  bool number_integer(number_integer_t value) override {
+    if (atTop() && currentKey == "timestamp") {
+      fields.timestamp = value;
+    }
+    return true;
+  }
+  bool number_unsigned(number_unsigned_t value) override {
+    if (atTop() && currentKey == "timestamp") {
+      fields.timestamp = static_cast<long long>(value);
+    }
+    return true;
+  }
+  bool number_float(number_float_t value, const string_t &) override {
+    if (atTop() && currentKey == "timestamp") {
+      fields.timestamp = static_cast<long long>(value);
+    }
+    return true;
+  }
+  bool string(string_t &value) override {
+    if (!atTop()) {
+      return true;
+    }
+    if (currentKey == "url") {
+      fields.url = std::move(value);
+    } else if (currentKey == "type") {
+      fields.type = std::move(value);
+    } else if (currentKey == "agent") {
+      fields.agent = std::move(value);
+    } else if (currentKey == "hash") {
+      fields.hash = std::move(value);
+    }
+    return true;
+  }
+  bool binary(binary_t &) override { return true; }
+  bool start_object(std::size_t) override {
+    ++depth;
+    return true;
+  }
+  bool key(string_t &value) override {
+    if (depth == 1) {
+      currentKey = std::move(value);
+    }
+    return true;
+  }
+  bool end_object() override {
+    --depth;
+    return true;
+  }
+  bool start_array(std::size_t) override {
+    ++depth;
+    return true;
+  }
+  bool end_array() override {
+    --depth;
+    return true;
+  }
+  bool parse_error(std::size_t, const std::string &,
+                   const nlohmann::detail::exception &) override {
+    return false;
+  }
+
+private:
+  bool atTop() const { return depth == 1; }
+
+  SnapshotFields &fields;
+  int depth = 0;
+  std::string currentKey;
+};
+
+} // namespace
+
+bool readSnapshotFile(const std::filesystem::path &path,
+                      SnapshotFields &fields,
+                      const HtmlPayloadExtractor::Sink &htmlSink) {
+  fields = SnapshotFields{};
+  MappedFile file(path);
+  if (!file.isOpen()) {
+    return false;
+  }
+
+  // finish() only hands over bytes that are not an html value (a payload
+  // without one), and those are not wanted here
+  bool finishing = false;
+  HtmlPayloadExtractor extractor(
+      [&htmlSink, &finishing](const char *data, size_t size) {
+        return finishing || !htmlSink || htmlSink(data, size);
+      });
+  // Fed in slices so the extractor's per-call scratch stays small
+  constexpr size_t kSlice = 64 * 1024;
+  for (size_t offset = 0; offset < file.size(); offset += kSlice) {
+    const size_t size = std::min(kSlice, file.size() - offset);
+    if (!extractor.feed(file.data() + offset, size)) {
+      return false;
+    }
+  }
+  finishing = true;
+  if (!extractor.finish() || !extractor.isJsonPayload()) {
+    return false;
+  }
+  fields.hasHtml = extractor.hasHtml();
+
+  SnapshotFieldsSax sax(fields);
+  return nlohmann::json::sax_parse(extractor.metadata(), &sax);
+}
+
+bool readSnapshotFile(const std::filesystem::path &path,
+                      SnapshotFields &fields, std::string &html) {
+  html.clear();
+  return readSnapshotFile(path, fields,
+                          [&html](const char *data, size_t size) {
+                            html.append(data, size);
+                            return true;
+                          });
+}
+
+} // namespace HT
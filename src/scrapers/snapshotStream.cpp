@@ -0,0 +1,295 @@
+#include <cctype>
+#include <scrapers/include/snapshotStream.hpp>
+
+namespace HT {
+
+static bool isJsonSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static void appendUtf8(uint32_t codePoint, std::string &out) {
+  if (codePoint < 0x80) {
+    out.push_back(static_cast<char>(codePoint));
+  } else if (codePoint < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+    out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  } else if (codePoint < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  }
+}
+
+HtmlPayloadExtractor::HtmlPayloadExtractor(Sink sink) : sink(std::move(sink)) {}
+
+bool HtmlPayloadExtractor::feed(const char *data, size_t size) {
+  if (mode == Mode::Passthrough) {
+    return size == 0 || sink(data, size);
+  }
+
+  std::string out; // unescaped html from this chunk
+  for (size_t i = 0; i < size; ++i) {
+    const char c = data[i];
+    switch (mode) {
+    case Mode::Detect:
+      if (isJsonSpace(c)) {
+        outside.push_back(c);
+        break;
+      }
+      if (c == '{') {
+        mode = Mode::Json;
+        feedJson(c);
+        break;
+      }
+      // Plain HTML: hand over what was held back and the rest as is
+      mode = Mode::Passthrough;
+      if (!outside.empty() && !sink(outside.data(), outside.size())) {
+        return false;
+      }
+      outside.clear();
+      return sink(data + i, size - i);
+
+    case Mode::Json:
+      feedJson(c);
+      break;
+
+    case Mode::HtmlValue: {
+      // Copy runs of ordinary characters in one go
+      if (escape == Escape::None && highSurrogate == 0) {
+        size_t end = i;
+        while (end < size && data[end] != '"' && data[end] != '\\') {
+          ++end;
+        }
+        out.append(data + i, end - i);
+        i = end;
+        if (i == size) {
+          break;
+        }
+      }
+      if (!feedHtmlValue(data[i], out)) {
+        return false;
+      }
+      break;
+    }
+
+    case Mode::Passthrough:
+      break; // handled above
+    }
+  }
+
+  return out.empty() || sink(out.data(), out.size());
+}
+
+// Tracks just enough of the JSON structure to spot the value of the
+// top-level "html" key. Every byte outside that value is kept.
+void HtmlPayloadExtractor::feedJson(char c) {
+  outside.push_back(c);
+
+  if (inString) {
+    if (stringEscape) {
+      stringEscape = false;
+    } else if (c == '\\') {
+      stringEscape = true;
+    } else if (c == '"') {
+      inString = false;
+      readingKey = false;
+      return;
+    }
+    if (readingKey) {
+      key.push_back(c);
+    }
+    return;
+  }
+
+  switch (c) {
+  case '"':
+    if (depth == 1 && expectValue && !htmlFound && key == "html") {
+      mode = Mode::HtmlValue; // outside keeps the quotes of an empty string
+      expectValue = false;
+      return;
+    }
+    inString = true;
+    if (depth == 1 && expectKey) {
+      readingKey = true;
+      key.clear();
+    }
+    expectKey = false;
+    expectValue = false;
+    break;
+  case '{':
+  case '[':
+    if (depth == 0 && c == '{') {
+      expectKey = true;
+    }
+    ++depth;
+    expectValue = false;
+    break;
+  case '}':
+  case ']':
+    --depth;
+    break;
+  case ':':
+    if (depth == 1) {
+      expectValue = true;
+    }
+    break;
+  case ',':
+    if (depth == 1) {
+      expectKey = true;
+      expectValue = false;
+    }
+    break;
+  default:
+    if (!isJsonSpace(c)) {
+      expectValue = false; // number, true, false or null
+    }
+    break;
+  }
+}
+
+bool HtmlPayloadExtractor::feedHtmlValue(char c, std::string &out) {
+  switch (escape) {
+  case Escape::None:
+    if (c == '\\') {
+      escape = Escape::Backslash;
+      return true;
+    }
+    if (highSurrogate != 0) {
+      appendUtf8(0xFFFD, out); // high surrogate without its pair
+      highSurrogate = 0;
+    }
+    if (c == '"') {
+      outside.push_back(c);
+      mode = Mode::Json;
+      htmlFound = true;
+      return true;
+    }
+    out.push_back(c);
+    return true;
+
+  case Escape::Backslash:
+    escape = Escape::None;
+    if (c == 'u') {
+      escape = Escape::Unicode;
+      hexDigits.clear();
+      return true;
+    }
+    if (highSurrogate != 0) {
+      appendUtf8(0xFFFD, out);
+      highSurrogate = 0;
+    }
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      out.push_back(c);
+      return true;
+    case 'b':
+      out.push_back('\b');
+      return true;
+    case 'f':
+      out.push_back('\f');
+      return true;
+    case 'n':
+      out.push_back('\n');
+      return true;
+    case 'r':
+      out.push_back('\r');
+      return true;
+    case 't':
+      out.push_back('\t');
+      return true;
+    default:
+      return false; // not valid JSON
+    }
+
+  case Escape::Unicode: {
+    if (!std::isxdigit(static_cast<unsigned char>(c))) {
+      return false;
+    }
+    hexDigits.push_back(c);
+    if (hexDigits.size() < 4) {
+      return true;
+    }
+    escape = Escape::None;
+    const uint32_t unit = std::stoul(hexDigits, nullptr, 16);
+
+    if (unit >= 0xD800 && unit <= 0xDBFF) {
+      if (highSurrogate != 0) {
+        appendUtf8(0xFFFD, out);
+      }
+      highSurrogate = unit;
+    } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+      if (highSurrogate != 0) {
+        appendUtf8(0x10000 + ((highSurrogate - 0xD800) << 10) +
+                       (unit - 0xDC00),
+                   out);
+        highSurrogate = 0;
+      } else {
+        appendUtf8(0xFFFD, out);
+      }
+    } else {
+      if (highSurrogate != 0) {
+        appendUtf8(0xFFFD, out);
+        highSurrogate = 0;
+      }
+      appendUtf8(unit, out);
+    }
+    return true;
+  }
+  }
+  return false;
+}
+
+bool HtmlPayloadExtractor::finish() {
+  switch (mode) {
+  case Mode::Detect:
+    // Nothing but whitespace arrived
+    if (!outside.empty() && !sink(outside.data(), outside.size())) {
+      return false;
+    }
+    outside.clear();
+    mode = Mode::Passthrough;
+    return true;
+
+  case Mode::Passthrough:
+    return true;
+
+  case Mode::Json:
+    if (htmlFound) {
+      return depth == 0 && !inString;
+    }
+    // Valid or not, a payload without an "html" string is kept as it came
+    return sink(outside.data(), outside.size());
+
+  case Mode::HtmlValue:
+    return false; // the body ended inside the html value
+  }
+  return false;
+}
+
+SnapshotStream::SnapshotStream(const std::filesystem::path &rawHtmlDir)
+    : blob(rawHtmlDir), extractor([this](const char *data, size_t size) {
+        return blob.write(data, size);
+      }) {}
+
+bool SnapshotStream::write(const char *data, size_t size) {
+  return extractor.feed(data, size);
+}
+
+std::string SnapshotStream::commit() {
+  if (!extractor.finish() || blob.size() == 0) {
+    blob.abort();
+    return "";
+  }
+  return blob.commit();
+}
+
+void SnapshotStream::abort() { blob.abort(); }
+
+} // namespace HT
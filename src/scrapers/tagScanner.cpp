@@ -0,0 +1,1633 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <scrapers/betri/betriParser.hpp>
+#include <scrapers/include/PropertyManager.hpp>
+#include <scrapers/include/gumboArena.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
+#include <scrapers/include/tagScanner.hpp>
+#include <scrapers/skyn/skynParser.hpp>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace HT {
+namespace {
+
+// What the scanner needs to know about a tag name. Most of them mirror a
+// category of the HTML tree construction rules Gumbo implements.
+enum TagFlag : unsigned {
+  Void = 1u << 0,          // never has children
+  RawText = 1u << 1,       // content is text up to the matching end tag
+  Special = 1u << 2,       // "special" elements
+  ClosesP = 1u << 3,       // a start tag closes an open <p>
+  Formatting = 1u << 4,    // kept in the list of active formatting elements
+  TableRow = 1u << 5,      // table, tbody, thead, tfoot, tr
+  Cell = 1u << 6,          // td, th, caption
+  Scope = 1u << 7,         // ends the search for an open <p>
+  Foreign = 1u << 8,       // svg, math
+  BreaksForeign = 1u << 9, // an HTML tag that ends svg or math content
+  Unsupported = 1u << 10,  // the scanner leaves pages with it inside a root
+                           // to Gumbo
+  Template = 1u << 11,
+  Plaintext = 1u << 12,
+  Script = 1u << 13,
+  ListItem = 1u << 14,  // li
+  DefItem = 1u << 15,   // dd, dt
+  Heading = 1u << 16,   // h1 to h6
+  Anchor = 1u << 17,    // a
+  Button = 1u << 18,    // button
+  Paragraph = 1u << 19, // p
+  Select = 1u << 20,
+  Document = 1u << 21,         // html, head, body: never tracked
+  IntegrationPoint = 1u << 22, // HTML content inside svg
+  ListExempt = 1u << 23,       // address, div, p: li and dd look past them
+  InForeign = 1u << 24,        // set on open elements inside svg or math
+  KeptRawText = 1u << 25,      // script, style: read inside a root
+  ImpliedEnd = 1u << 26,       // li, dd, dt, p: closed by their parent's end
+};
+
+unsigned tagFlags(std::string_view name) {
+  static const std::unordered_map<std::string_view, unsigned> flags = [] {
+    std::unordered_map<std::string_view, unsigned> table;
+    auto add = [&](std::initializer_list<std::string_view> names,
+                   unsigned flag) {
+      for (auto name : names) {
+        table[name] |= flag;
+      }
+    };
+    add({"area", "base", "basefont", "bgsound", "br", "col", "embed", "frame",
+         "hr", "img", "input", "keygen", "link", "meta", "param", "source",
+         "track", "wbr"},
+        Void);
+    add({"script", "style", "xmp", "iframe", "noembed", "noframes", "title",
+         "textarea"},
+        RawText);
+    add({"address",  "applet",     "area",     "article", "aside",
+         "base",     "basefont",   "bgsound",  "blockquote", "body",
+         "br",       "button",     "caption",  "center",  "col",
+         "colgroup", "dd",         "details",  "dir",     "div",
+         "dl",       "dt",         "embed",    "fieldset", "figcaption",
+         "figure",   "footer",     "form",     "frame",   "frameset",
+         "h1",       "h2",         "h3",       "h4",      "h5",
+         "h6",       "head",       "header",   "hgroup",  "hr",
+         "html",     "iframe",     "img",      "input",   "isindex",
+         "li",       "link",       "listing",  "main",    "marquee",
+         "menu",     "menuitem",   "meta",     "nav",     "noembed",
+         "noframes", "noscript",   "object",   "ol",      "p",
+         "param",    "plaintext",  "pre",      "script",  "section",
+         "select",   "source",     "style",    "summary", "table",
+         "tbody",    "td",         "template", "textarea", "tfoot",
+         "th",       "thead",      "title",    "tr",      "track",
+         "ul",       "wbr",        "xmp"},
+        Special);
+    add({"address", "article", "aside", "blockquote", "center", "details",
+         "dialog", "dir", "div", "dl", "fieldset", "figcaption", "figure",
+         "footer", "header", "hgroup", "main", "menu", "nav", "ol", "p",
+         "section", "summary", "ul", "h1", "h2", "h3", "h4", "h5", "h6",
+         "pre", "listing", "form", "plaintext", "table", "hr", "xmp", "li",
+         "dd", "dt"},
+        ClosesP);
+    add({"a", "b", "big", "code", "em", "font", "i", "nobr", "s", "small",
+         "strike", "strong", "tt", "u"},
+        Formatting);
+    add({"table", "tbody", "thead", "tfoot", "tr"}, TableRow);
+    add({"td", "th", "caption"}, Cell);
+    add({"applet", "button", "caption", "html", "marquee", "object", "table",
+         "td", "template", "th"},
+        Scope);
+    add({"svg", "math"}, Foreign);
+    add({"b",      "big",    "blockquote", "body", "br",   "center", "code",
+         "dd",     "div",    "dl",         "dt",   "em",   "embed",  "font",
+         "h1",     "h2",     "h3",         "h4",   "h5",   "h6",     "head",
+         "hr",     "i",      "img",        "li",   "listing", "menu",
+         "meta",   "nobr",   "ol",         "p",    "pre",  "ruby",   "s",
+         "small",  "span",   "strong",     "strike", "sub", "sup",   "table",
+         "tt",     "u",      "ul",         "var"},
+        BreaksForeign);
+    add({"applet",    "base",     "basefont", "bgsound",  "body",
+         "caption",   "col",      "colgroup", "form",     "frame",
+         "frameset",  "head",     "html",     "iframe",   "image",
+         "isindex",   "keygen",   "link",     "listing",  "marquee",
+         "math",      "menuitem", "meta",     "nobr",     "noembed",
+         "noframes",  "noscript", "object",   "optgroup", "option",
+         "plaintext", "pre",      "rb",       "rp",       "rt",
+         "rtc",       "select",   "table",    "tbody",    "td",
+         "textarea",  "tfoot",    "th",       "thead",    "title",
+         "tr",        "xmp"},
+        Unsupported);
+    add({"template"}, Template);
+    add({"plaintext"}, Plaintext);
+    add({"script"}, Script);
+    add({"li"}, ListItem);
+    add({"dd", "dt"}, DefItem);
+    add({"h1", "h2", "h3", "h4", "h5", "h6"}, Heading);
+    add({"a"}, Anchor);
+    add({"button"}, Button);
+    add({"p"}, Paragraph);
+    add({"select"}, Select);
+    add({"html", "head", "body"}, Document);
+    add({"foreignobject", "desc", "title"}, IntegrationPoint);
+    add({"address", "div", "p"}, ListExempt);
+    add({"script", "style"}, KeptRawText);
+    add({"li", "dd", "dt", "p"}, ImpliedEnd);
+    return table;
+  }();
+  auto it = flags.find(name);
+  return it == flags.end() ? 0u : it->second;
+}
+
+// Attributes of svg elements Gumbo gives their mixed case back
+constexpr std::string_view kSvgAttributes[] = {
+    "attributeName",     "attributeType",       "baseFrequency",
+    "baseProfile",       "calcMode",            "clipPathUnits",
+    "diffuseConstant",   "edgeMode",            "filterUnits",
+    "glyphRef",          "gradientTransform",   "gradientUnits",
+    "kernelMatrix",      "kernelUnitLength",    "keyPoints",
+    "keySplines",        "keyTimes",            "lengthAdjust",
+    "limitingConeAngle", "markerHeight",        "markerUnits",
+    "markerWidth",       "maskContentUnits",    "maskUnits",
+    "numOctaves",        "pathLength",          "patternContentUnits",
+    "patternTransform",  "patternUnits",        "pointsAtX",
+    "pointsAtY",         "pointsAtZ",           "preserveAlpha",
+    "preserveAspectRatio", "primitiveUnits",    "refX",
+    "refY",              "repeatCount",         "repeatDur",
+    "requiredExtensions", "requiredFeatures",   "specularConstant",
+    "specularExponent",  "spreadMethod",        "startOffset",
+    "stdDeviation",      "stitchTiles",         "surfaceScale",
+    "systemLanguage",    "tableValues",         "targetX",
+    "targetY",           "textLength",          "viewBox",
+    "viewTarget",        "xChannelSelector",    "yChannelSelector",
+    "zoomAndPan",
+};
+
+// Attributes of svg elements Gumbo moves to a namespace of their own
+struct ForeignAttribute {
+  std::string_view name;
+  std::string_view localName;
+  GumboAttributeNamespaceEnum attributeNamespace;
+};
+
+constexpr ForeignAttribute kForeignAttributes[] = {
+    {"xlink:actuate", "actuate", GUMBO_ATTR_NAMESPACE_XLINK},
+    {"xlink:arcrole", "arcrole", GUMBO_ATTR_NAMESPACE_XLINK},
+    {"xlink:href", "href", GUMBO_ATTR_NAMESPACE_XLINK},
+    {"xlink:role", "role", GUMBO_ATTR_NAMESPACE_XLINK},
+    {"xlink:show", "show", GUMBO_ATTR_NAMESPACE_XLINK},
+    {"xlink:title", "title", GUMBO_ATTR_NAMESPACE_XLINK},
+    {"xlink:type", "type", GUMBO_ATTR_NAMESPACE_XLINK},
+    {"xml:base", "base", GUMBO_ATTR_NAMESPACE_XML},
+    {"xml:lang", "lang", GUMBO_ATTR_NAMESPACE_XML},
+    {"xml:space", "space", GUMBO_ATTR_NAMESPACE_XML},
+    {"xmlns", "xmlns", GUMBO_ATTR_NAMESPACE_XMLNS},
+    {"xmlns:xlink", "xlink", GUMBO_ATTR_NAMESPACE_XMLNS},
+};
+
+// The named character references the scanner resolves: every one that may
+// appear without its semicolon, and a few common ones that may not. A page
+// using any other one goes to Gumbo.
+struct Reference {
+  std::string_view name;
+  char32_t codePoint;
+  bool withoutSemicolon;
+};
+
+constexpr size_t kLongestLegacyName = 6; // "frac12", "Ntilde", ...
+
+// Sorted by name, for std::lower_bound
+constexpr Reference kReferences[] = {
+    {"AElig", 0xC6, true}, {"AMP", 0x26, true}, {"Aacute", 0xC1, true},
+    {"Acirc", 0xC2, true}, {"Agrave", 0xC0, true}, {"Aring", 0xC5, true},
+    {"Atilde", 0xC3, true}, {"Auml", 0xC4, true}, {"COPY", 0xA9, true},
+    {"Ccedil", 0xC7, true}, {"Dagger", 0x2021, false}, {"ETH", 0xD0, true},
+    {"Eacute", 0xC9, true}, {"Ecirc", 0xCA, true}, {"Egrave", 0xC8, true},
+    {"Euml", 0xCB, true}, {"GT", 0x3E, true}, {"Iacute", 0xCD, true},
+    {"Icirc", 0xCE, true}, {"Igrave", 0xCC, true}, {"Iuml", 0xCF, true},
+    {"LT", 0x3C, true}, {"Ntilde", 0xD1, true}, {"OElig", 0x152, false},
+    {"Oacute", 0xD3, true}, {"Ocirc", 0xD4, true}, {"Ograve", 0xD2, true},
+    {"Oslash", 0xD8, true}, {"Otilde", 0xD5, true}, {"Ouml", 0xD6, true},
+    {"QUOT", 0x22, true}, {"REG", 0xAE, true}, {"Scaron", 0x160, false},
+    {"THORN", 0xDE, true}, {"Uacute", 0xDA, true}, {"Ucirc", 0xDB, true},
+    {"Ugrave", 0xD9, true}, {"Uuml", 0xDC, true}, {"Yacute", 0xDD, true},
+    {"Yuml", 0x178, false}, {"aacute", 0xE1, true}, {"acirc", 0xE2, true},
+    {"acute", 0xB4, true}, {"aelig", 0xE6, true}, {"agrave", 0xE0, true},
+    {"amp", 0x26, true}, {"apos", 0x27, false}, {"aring", 0xE5, true},
+    {"atilde", 0xE3, true}, {"auml", 0xE4, true}, {"bdquo", 0x201E, false},
+    {"brvbar", 0xA6, true}, {"bull", 0x2022, false}, {"ccedil", 0xE7, true},
+    {"cedil", 0xB8, true}, {"cent", 0xA2, true}, {"circ", 0x2C6, false},
+    {"copy", 0xA9, true}, {"curren", 0xA4, true}, {"dagger", 0x2020, false},
+    {"deg", 0xB0, true}, {"divide", 0xF7, true}, {"eacute", 0xE9, true},
+    {"ecirc", 0xEA, true}, {"egrave", 0xE8, true}, {"emsp", 0x2003, false},
+    {"ensp", 0x2002, false}, {"eth", 0xF0, true}, {"euml", 0xEB, true},
+    {"euro", 0x20AC, false}, {"fnof", 0x192, false}, {"frac12", 0xBD, true},
+    {"frac14", 0xBC, true}, {"frac34", 0xBE, true}, {"gt", 0x3E, true},
+    {"hellip", 0x2026, false}, {"iacute", 0xED, true}, {"icirc", 0xEE, true},
+    {"iexcl", 0xA1, true}, {"igrave", 0xEC, true}, {"iquest", 0xBF, true},
+    {"iuml", 0xEF, true}, {"laquo", 0xAB, true}, {"ldquo", 0x201C, false},
+    {"lrm", 0x200E, false}, {"lsaquo", 0x2039, false}, {"lsquo", 0x2018, false},
+    {"lt", 0x3C, true}, {"macr", 0xAF, true}, {"mdash", 0x2014, false},
+    {"micro", 0xB5, true}, {"middot", 0xB7, true}, {"nbsp", 0xA0, true},
+    {"ndash", 0x2013, false}, {"not", 0xAC, true}, {"ntilde", 0xF1, true},
+    {"oacute", 0xF3, true}, {"ocirc", 0xF4, true}, {"oelig", 0x153, false},
+    {"ograve", 0xF2, true}, {"ordf", 0xAA, true}, {"ordm", 0xBA, true},
+    {"oslash", 0xF8, true}, {"otilde", 0xF5, true}, {"ouml", 0xF6, true},
+    {"para", 0xB6, true}, {"permil", 0x2030, false}, {"plusmn", 0xB1, true},
+    {"pound", 0xA3, true}, {"quot", 0x22, true}, {"raquo", 0xBB, true},
+    {"rdquo", 0x201D, false}, {"reg", 0xAE, true}, {"rlm", 0x200F, false},
+    {"rsaquo", 0x203A, false}, {"rsquo", 0x2019, false},
+    {"sbquo", 0x201A, false}, {"scaron", 0x161, false}, {"sect", 0xA7, true},
+    {"shy", 0xAD, true}, {"sup1", 0xB9, true}, {"sup2", 0xB2, true},
+    {"sup3", 0xB3, true}, {"szlig", 0xDF, true}, {"thinsp", 0x2009, false},
+    {"thorn", 0xFE, true}, {"tilde", 0x2DC, false}, {"times", 0xD7, true},
+    {"trade", 0x2122, false}, {"uacute", 0xFA, true}, {"ucirc", 0xFB, true},
+    {"ugrave", 0xF9, true}, {"uml", 0xA8, true}, {"uuml", 0xFC, true},
+    {"yacute", 0xFD, true}, {"yen", 0xA5, true}, {"yuml", 0xFF, true},
+    {"zwj", 0x200D, false}, {"zwnj", 0x200C, false},
+};
+
+const Reference *findReference(std::string_view name) {
+  const auto *end = std::end(kReferences);
+  const auto *it = std::lower_bound(
+      std::begin(kReferences), end, name,
+      [](const Reference &ref, std::string_view n) { return ref.name < n; });
+  return it != end && it->name == name ? it : nullptr;
+}
+
+// Whitespace to the tokenizer; \r never survives input preprocessing
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\f' || c == '\r';
+}
+
+bool isAlpha(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+bool isAlnum(char c) { return isAlpha(c) || isDigit(c); }
+bool isHexDigit(char c) {
+  return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+char toLower(char c) { return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c; }
+
+// a and b are the same once lowercased
+bool equalsLowercase(std::string_view a, std::string_view b) {
+  return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                    [](char x, char y) { return toLower(x) == toLower(y); });
+}
+
+bool isTextWhitespace(char32_t c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\f';
+}
+
+bool isNoncharacter(char32_t c) {
+  return (c >= 0xFDD0 && c <= 0xFDEF) || (c & 0xFFFE) == 0xFFFE;
+}
+
+// Code points Gumbo keeps as they are. It replaces control characters,
+// noncharacters and what numeric references map specially (C1, 0,
+// surrogates, out of range), so the scanner gives those pages up.
+bool isPlainCodePoint(char32_t c) {
+  if (c < 0xA0) {
+    return isTextWhitespace(c) || (c >= 0x20 && c < 0x7F);
+  }
+  return c <= 0x10FFFF && (c < 0xD800 || c > 0xDFFF) && !isNoncharacter(c);
+}
+
+void appendUtf8(std::string &out, char32_t c) {
+  if (c < 0x80) {
+    out += static_cast<char>(c);
+  } else if (c < 0x800) {
+    out += static_cast<char>(0xC0 | (c >> 6));
+    out += static_cast<char>(0x80 | (c & 0x3F));
+  } else if (c < 0x10000) {
+    out += static_cast<char>(0xE0 | (c >> 12));
+    out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (c & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (c >> 18));
+    out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (c & 0x3F));
+  }
+}
+
+// Length of the UTF-8 sequence at s[i], or 0 if it is invalid or encodes a
+// code point Gumbo would replace
+size_t utf8Length(std::string_view s, size_t i) {
+  const auto byte = [&](size_t k) {
+    return static_cast<unsigned char>(k < s.size() ? s[k] : 0);
+  };
+  const unsigned char c = byte(i);
+  size_t length;
+  char32_t cp;
+  unsigned char low = 0x80, high = 0xBF; // range of the second byte
+  if (c >= 0xC2 && c <= 0xDF) {
+    length = 2;
+    cp = c & 0x1F;
+  } else if (c >= 0xE0 && c <= 0xEF) {
+    length = 3;
+    cp = c & 0x0F;
+    low = c == 0xE0 ? 0xA0 : 0x80;
+    high = c == 0xED ? 0x9F : 0xBF;
+  } else if (c >= 0xF0 && c <= 0xF4) {
+    length = 4;
+    cp = c & 0x07;
+    low = c == 0xF0 ? 0x90 : 0x80;
+    high = c == 0xF4 ? 0x8F : 0xBF;
+  } else {
+    return 0;
+  }
+  for (size_t k = 1; k < length; ++k) {
+    const unsigned char next = byte(i + k);
+    if (next < (k == 1 ? low : 0x80) || next > (k == 1 ? high : 0xBF)) {
+      return 0;
+    }
+    cp = (cp << 6) | (next & 0x3F);
+  }
+  return isPlainCodePoint(cp) ? length : 0;
+}
+
+// Where characters appear, which decides how Gumbo decodes them
+enum class Context {
+  Text,
+  Attribute,
+  Raw, // comments, scripts and styles: no character references
+};
+
+// Resolves the character reference at raw[i] (an '&') like Gumbo's
+// tokenizer and moves i past it; false if it is one the scanner leaves to
+// Gumbo
+bool appendReference(std::string_view raw, size_t &i, bool inAttribute,
+                     std::string &out, bool &whitespace) {
+  auto emit = [&](char32_t c) {
+    appendUtf8(out, c);
+    whitespace = whitespace && isTextWhitespace(c);
+  };
+  const size_t start = i + 1;
+  if (start < raw.size() && raw[start] == '#') {
+    size_t j = start + 1;
+    const bool hex = j < raw.size() && (raw[j] == 'x' || raw[j] == 'X');
+    j += hex ? 1 : 0;
+    const size_t digits = j;
+    char32_t value = 0;
+    for (; j < raw.size() && (hex ? isHexDigit(raw[j]) : isDigit(raw[j]));
+         ++j) {
+      const char d = toLower(raw[j]);
+      value = std::min<char32_t>(
+          value * (hex ? 16 : 10) + (isDigit(d) ? d - '0' : d - 'a' + 10),
+          0x110000);
+    }
+    if (j > digits) {
+      if (!isPlainCodePoint(value)) {
+        return false;
+      }
+      emit(value);
+      i = j < raw.size() && raw[j] == ';' ? j + 1 : j;
+      return true;
+    }
+  } else if (start < raw.size() && isAlnum(raw[start])) {
+    size_t end = start;
+    while (end < raw.size() && isAlnum(raw[end])) {
+      ++end;
+    }
+    const std::string_view name = raw.substr(start, end - start);
+    if (end < raw.size() && raw[end] == ';') {
+      const Reference *ref = findReference(name);
+      if (!ref) {
+        return false; // maybe one of the two thousand others
+      }
+      emit(ref->codePoint);
+      i = end + 1;
+      return true;
+    }
+    // Without a semicolon only the legacy names count, the longest first
+    for (size_t length = std::min(name.size(), kLongestLegacyName);
+         length > 0; --length) {
+      const Reference *ref = findReference(name.substr(0, length));
+      if (!ref || !ref->withoutSemicolon) {
+        continue;
+      }
+      const size_t after = start + length;
+      if (inAttribute && after < raw.size() &&
+          (isAlnum(raw[after]) || raw[after] == '=')) {
+        break; // "&copy=1" in a url stays as it is
+      }
+      emit(ref->codePoint);
+      i = after;
+      return true;
+    }
+  }
+  emit('&');
+  i = start;
+  return true;
+}
+
+// Appends raw as Gumbo would see it: character references resolved and line
+// breaks normalized. whitespace is cleared once anything but whitespace is
+// appended. False if raw holds something the scanner leaves to Gumbo.
+bool appendDecoded(std::string_view raw, Context context, std::string &out,
+                   bool &whitespace) {
+  const char reference = context == Context::Raw ? '\0' : '&';
+  size_t i = 0;
+  while (i < raw.size()) {
+    size_t run = i;
+    for (; run < raw.size(); ++run) {
+      const char c = raw[run];
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\f') {
+        continue;
+      }
+      if (c < 0x20 || c >= 0x7F || c == reference) {
+        break;
+      }
+      whitespace = false;
+    }
+    out.append(raw.data() + i, run - i);
+    i = run;
+    if (i >= raw.size()) {
+      break;
+    }
+
+    const char c = raw[i];
+    if (c == '\r') {
+      out += '\n';
+      i += i + 1 < raw.size() && raw[i + 1] == '\n' ? 2 : 1;
+    } else if (c == reference) {
+      if (!appendReference(raw, i, context == Context::Attribute, out,
+                           whitespace)) {
+        return false;
+      }
+    } else {
+      const size_t length = utf8Length(raw, i);
+      if (length == 0) {
+        return false;
+      }
+      out.append(raw.data() + i, length);
+      whitespace = false;
+      i += length;
+    }
+  }
+  return true;
+}
+
+struct RawAttribute {
+  std::string_view name;  // as written
+  std::string_view value; // with its character references
+};
+
+struct OpenElement {
+  std::string name;
+  unsigned flags;
+  GumboNode *node; // inside a root only
+};
+
+class Scanner {
+public:
+  Scanner(std::string_view in, bool (*isRoot)(const char *),
+          const std::function<void(GumboNode *)> &found, GumboArena &arena)
+      : in(in), isRoot(isRoot), found(found), arena(arena) {}
+
+  bool run() {
+    size_t textStart = 0;
+    while (!done) {
+      const size_t lt = in.find('<', pos);
+      if (lt == std::string_view::npos) {
+        break; // the rest is text
+      }
+      const Markup markup = readMarkup(lt);
+      if (markup == Text) {
+        pos = lt + 1;
+        continue;
+      }
+      if (!region.empty() && !flushText(textStart, lt)) {
+        return false;
+      }
+      bool ok = true;
+      switch (markup) {
+      case Comment:
+        ok = region.empty() || addComment();
+        break;
+      case Bogus:
+        ok = region.empty();
+        break;
+      case StartTag:
+        ok = region.empty() ? outsideStart() : regionStart();
+        break;
+      case EndTag:
+        ok = region.empty() ? outsideEnd() : regionEnd();
+        break;
+      case Text:
+        break;
+      }
+      if (!ok) {
+        return false;
+      }
+      textStart = pos;
+    }
+    // A root still open at the end of the page is closed by Gumbo along
+    // with everything in it; the scanner does not guess at that
+    return region.empty();
+  }
+
+private:
+  enum Markup { Text, Comment, Bogus, StartTag, EndTag };
+
+  // What starts at in[lt] == '<'. Moves pos past comments and tags, and
+  // to the end of the input when one is cut off. Tags are read into
+  // tagName, attributes and selfClosing.
+  Markup readMarkup(size_t lt) {
+    const size_t size = in.size();
+    const char next = lt + 1 < size ? in[lt + 1] : '\0';
+    if (isAlpha(next)) {
+      return readTag(lt + 1) ? StartTag : cutOff();
+    }
+    if (next == '/') {
+      const char after = lt + 2 < size ? in[lt + 2] : '\0';
+      if (isAlpha(after)) {
+        return readTag(lt + 2) ? EndTag : cutOff();
+      }
+      if (after == '>') {
+        pos = lt + 3; // "</>" is dropped
+        return Bogus;
+      }
+      if (lt + 2 >= size) {
+        return Text;
+      }
+      return skipTo(">", lt + 2, Bogus);
+    }
+    if (next == '!') {
+      if (startsWith(lt + 2, "--")) {
+        const size_t body = lt + 4;
+        comment = in.substr(body, 0);
+        if (startsWith(body, ">")) {
+          pos = body + 1;
+          return Comment;
+        }
+        if (startsWith(body, "->")) {
+          pos = body + 2;
+          return Comment;
+        }
+        const size_t end =
+            std::min(in.find("-->", body), in.find("--!>", body));
+        if (end == std::string_view::npos) {
+          comment = in.substr(body);
+          pos = size;
+        } else {
+          comment = in.substr(body, end - body);
+          pos = end + (in[end + 2] == '!' ? 4 : 3);
+        }
+        return Comment;
+      }
+      if (inForeign() && startsWith(lt + 2, "[CDATA[")) {
+        return skipTo("]]>", lt + 9, Bogus);
+      }
+      return skipTo(">", lt + 2, Bogus);
+    }
+    if (next == '?') {
+      return skipTo(">", lt + 2, Bogus);
+    }
+    return Text;
+  }
+
+  bool startsWith(size_t at, std::string_view prefix) const {
+    return at <= in.size() && in.substr(at).substr(0, prefix.size()) == prefix;
+  }
+
+  Markup skipTo(std::string_view end, size_t from, Markup markup) {
+    const size_t at = in.find(end, from);
+    pos = at == std::string_view::npos ? in.size() : at + end.size();
+    return markup;
+  }
+
+  // Gumbo drops a tag cut off by the end of the input
+  Markup cutOff() {
+    pos = in.size();
+    done = true;
+    return Bogus;
+  }
+
+  // Reads the tag whose name starts at p; false if the input ends first
+  bool readTag(size_t p) {
+    const size_t size = in.size();
+    const size_t nameStart = p;
+    while (p < size && !isSpace(in[p]) && in[p] != '/' && in[p] != '>') {
+      ++p;
+    }
+    setTagName(in.substr(nameStart, p - nameStart));
+    attributes.clear();
+    selfClosing = false;
+    while (true) {
+      while (p < size && isSpace(in[p])) {
+        ++p;
+      }
+      if (p >= size) {
+        return false;
+      }
+      if (in[p] == '>') {
+        pos = p + 1;
+        return true;
+      }
+      if (in[p] == '/') {
+        ++p;
+        if (p < size && in[p] == '>') {
+          selfClosing = true;
+          pos = p + 1;
+          return true;
+        }
+        continue;
+      }
+
+      const size_t attributeStart = p++; // may start with '='
+      while (p < size && !isSpace(in[p]) && in[p] != '/' && in[p] != '>' &&
+             in[p] != '=') {
+        ++p;
+      }
+      RawAttribute &attribute = attributes.emplace_back();
+      attribute.name = in.substr(attributeStart, p - attributeStart);
+      while (p < size && isSpace(in[p])) {
+        ++p;
+      }
+      if (p >= size || in[p] != '=') {
+        continue;
+      }
+      ++p;
+      while (p < size && isSpace(in[p])) {
+        ++p;
+      }
+      if (p >= size) {
+        return false;
+      }
+      const char quote = in[p];
+      if (quote == '"' || quote == '\'') {
+        const size_t close = in.find(quote, p + 1);
+        if (close == std::string_view::npos) {
+          return false;
+        }
+        attribute.value = in.substr(p + 1, close - p - 1);
+        p = close + 1;
+      } else if (quote != '>') {
+        const size_t valueStart = p;
+        while (p < size && !isSpace(in[p]) && in[p] != '>') {
+          ++p;
+        }
+        attribute.value = in.substr(valueStart, p - valueStart);
+      }
+    }
+  }
+
+  void setTagName(std::string_view raw) {
+    tagName = raw;
+    if (std::none_of(raw.begin(), raw.end(),
+                     [](char c) { return c >= 'A' && c <= 'Z'; })) {
+      return;
+    }
+    nameBuffer.assign(raw);
+    for (auto &c : nameBuffer) {
+      c = toLower(c);
+    }
+    tagName = nameBuffer;
+  }
+
+  // The first class attribute, resolved; false if it cannot be
+  bool classAttribute(const char *&cls) {
+    cls = nullptr;
+    for (const auto &attribute : attributes) {
+      if (!equalsLowercase(attribute.name, "class")) {
+        continue;
+      }
+      valueBuffer.clear();
+      bool whitespace = true;
+      if (!appendDecoded(attribute.value, Context::Attribute, valueBuffer,
+                         whitespace)) {
+        return false;
+      }
+      cls = valueBuffer.c_str();
+      return true;
+    }
+    return true;
+  }
+
+  // Where the content of the raw text element just opened ends: at the
+  // "</" of its end tag, or npos if the page ends first
+  size_t rawTextEnd() const {
+    for (size_t end = in.find("</", pos); end != std::string_view::npos;
+         end = in.find("</", end + 2)) {
+      const size_t after = end + 2 + tagName.size();
+      if (after < in.size() &&
+          (isSpace(in[after]) || in[after] == '/' || in[after] == '>') &&
+          equalsLowercase(tagName, in.substr(end + 2, tagName.size()))) {
+        return end;
+      }
+    }
+    return std::string_view::npos;
+  }
+
+  // "<!--" in a script may hide its end tag
+  bool isPlainScript(unsigned flags, size_t end) const {
+    return !(flags & Script) ||
+           in.substr(pos, end - pos).find("<!--") == std::string_view::npos;
+  }
+
+  // Skips the content of a raw text element and its end tag
+  bool skipRawText(unsigned flags) {
+    const size_t end = rawTextEnd();
+    if (end == std::string_view::npos) {
+      done = true; // the rest of the page is its text
+      return true;
+    }
+    if (!isPlainScript(flags, end)) {
+      return false;
+    }
+    if (!readTag(end + 2)) {
+      done = true;
+    }
+    return true;
+  }
+
+  // A script or style inside a root: the element with its content as text
+  bool addRawText(unsigned flags) {
+    GumboNode *node = newElement(region.back().node, GUMBO_NAMESPACE_HTML);
+    const size_t end = rawTextEnd();
+    if (!node || end == std::string_view::npos || !isPlainScript(flags, end)) {
+      return false;
+    }
+    region.push_back({std::string(tagName), flags, node});
+    if (!addText(GUMBO_NODE_TEXT, in.substr(pos, end - pos), Context::Raw) ||
+        !readTag(end + 2)) {
+      return false;
+    }
+    region.pop_back();
+    return true;
+  }
+
+  // Skips a <template> and its content, which Gumbo keeps out of the
+  // element tree. Parsers disagree on where the content ends when elements
+  // in it are left open or closed out of order, so that, svg and the end of
+  // the page inside a template give the page up.
+  bool skipTemplate() {
+    std::vector<std::string> names{"template"};
+    while (!names.empty()) {
+      const size_t lt = in.find('<', pos);
+      if (lt == std::string_view::npos) {
+        done = true;
+        return false;
+      }
+      const Markup markup = readMarkup(lt);
+      if (done || markup == Bogus) {
+        return false;
+      }
+      if (markup == Text) {
+        pos = lt + 1;
+      } else if (markup == StartTag) {
+        const unsigned flags = tagFlags(tagName);
+        if (flags & (Foreign | Plaintext)) {
+          return false;
+        }
+        if (flags & RawText) {
+          if (!skipRawText(flags) || done) {
+            return false;
+          }
+          continue;
+        }
+        if (!(flags & Void)) {
+          names.emplace_back(tagName);
+        }
+      } else if (markup == EndTag) {
+        if (names.back() != tagName) {
+          return false;
+        }
+        names.pop_back();
+      }
+    }
+    return true;
+  }
+
+  bool inForeign() const {
+    const auto &stack = region.empty() ? open : region;
+    return !stack.empty() && (stack.back().flags & InForeign);
+  }
+
+  // Pops open elements down to and including open[index]. A formatting
+  // element closed by another element's end tag stays in Gumbo's list of
+  // active formatting elements and is recreated around later content.
+  void popOpenTo(size_t index) {
+    for (size_t i = index + 1; i < open.size(); ++i) {
+      strayFormatting |= (open[i].flags & Formatting) != 0;
+    }
+    open.resize(index);
+  }
+
+  // Index of the <p> a start tag would close, or npos
+  size_t openParagraph() const {
+    for (size_t i = open.size(); i-- > 0;) {
+      if (open[i].flags & Paragraph) {
+        return i;
+      }
+      if (open[i].flags & Scope) {
+        break;
+      }
+    }
+    return std::string::npos;
+  }
+
+  bool outsideStart() {
+    const unsigned flags = tagFlags(tagName);
+    if (inForeign() && (open.back().flags & IntegrationPoint)) {
+      return false; // HTML inside svg: not worth tracking
+    }
+    if (!inForeign()) {
+      if (flags & Template) {
+        return skipTemplate();
+      }
+      if (flags & Plaintext) {
+        done = true;
+        return true;
+      }
+      if (flags & RawText) {
+        return skipRawText(flags);
+      }
+      // A second <a> or <nobr> runs the adoption agency on the first
+      const bool reopens = (flags & Anchor) || tagName == "nobr";
+      if (reopens && std::any_of(open.begin(), open.end(),
+                                 [&](const OpenElement &e) {
+                                   return e.name == tagName;
+                                 })) {
+        strayFormatting = true;
+      }
+    }
+
+    // The elements this start tag closes first
+    if (inForeign() && (flags & BreaksForeign)) {
+      while (!open.empty() && (open.back().flags & InForeign)) {
+        open.pop_back();
+      }
+    }
+    if (!inForeign()) {
+      const size_t paragraph = openParagraph();
+      if ((flags & ClosesP) && paragraph != std::string::npos) {
+        popOpenTo(paragraph);
+      }
+      if (flags & (ListItem | DefItem)) {
+        const unsigned kind = flags & (ListItem | DefItem);
+        for (size_t i = open.size(); i-- > 0;) {
+          if (open[i].flags & kind) {
+            popOpenTo(i);
+            break;
+          }
+          if ((open[i].flags & Special) && !(open[i].flags & ListExempt)) {
+            break;
+          }
+        }
+      }
+      if ((flags & Heading) && !open.empty() &&
+          (open.back().flags & Heading)) {
+        open.pop_back();
+      }
+    }
+
+    const char *cls;
+    if (!classAttribute(cls)) {
+      return false;
+    }
+    if (cls && isRoot(cls)) {
+      return startRegion(flags);
+    }
+
+    const bool foreign = inForeign() || (flags & Foreign);
+    if ((flags & Document) || (foreign ? selfClosing : (flags & Void))) {
+      return true;
+    }
+    open.push_back({std::string(tagName), flags | (foreign ? InForeign : 0u),
+                    nullptr});
+    return true;
+  }
+
+  // The open element an end tag closes outside a root, following the end
+  // tag rules of Gumbo's "in body" mode; npos if it is ignored
+  size_t endTagTarget() const {
+    // svg elements are closed by name
+    for (size_t i = open.size(); i-- > 0 && (open[i].flags & InForeign);) {
+      if (open[i].name == tagName) {
+        return i;
+      }
+    }
+    const unsigned flags = tagFlags(tagName);
+    if (flags & Paragraph) {
+      return openParagraph();
+    }
+    if (flags & Special) {
+      // The element, or any heading for a heading, if it is in scope
+      for (size_t i = open.size(); i-- > 0;) {
+        if (open[i].name == tagName || (open[i].flags & flags & Heading)) {
+          return i;
+        }
+        if (open[i].flags & Scope) {
+          break;
+        }
+      }
+      return std::string::npos;
+    }
+    // Any other end tag closes the nearest element of its name, unless a
+    // special element is open inside it
+    for (size_t i = open.size(); i-- > 0;) {
+      if (open[i].name == tagName) {
+        return i;
+      }
+      if (open[i].flags & Special) {
+        break;
+      }
+    }
+    return std::string::npos;
+  }
+
+  bool outsideEnd() {
+    const size_t target = endTagTarget();
+    if (target == std::string::npos) {
+      return true;
+    }
+    // A misnested formatting element is taken apart by the adoption agency
+    if ((open[target].flags & Formatting) && target + 1 < open.size()) {
+      strayFormatting = true;
+    }
+    popOpenTo(target);
+    return true;
+  }
+
+  // Starts building a root. Gumbo would restructure what is inside it if it
+  // sat in a table, a select or svg, or if formatting elements were open or
+  // waiting to be recreated, so those pages are left to Gumbo.
+  bool startRegion(unsigned flags) {
+    if (strayFormatting || inForeign() ||
+        (flags & (Unsupported | RawText | Template | Foreign))) {
+      return false;
+    }
+    for (size_t i = open.size(); i-- > 0;) {
+      if (open[i].flags & (Formatting | Select | Button)) {
+        return false;
+      }
+      if ((open[i].flags & TableRow) &&
+          std::none_of(open.begin() + i, open.end(),
+                       [](const OpenElement &e) { return e.flags & Cell; })) {
+        return false;
+      }
+    }
+    paragraphAround = openParagraph() != std::string::npos;
+
+    GumboNode *root = newElement(nullptr, GUMBO_NAMESPACE_HTML);
+    if (!root) {
+      return false;
+    }
+    if (flags & Void) {
+      found(root);
+      return true;
+    }
+    region.push_back({std::string(tagName), flags, root});
+    return true;
+  }
+
+  bool regionHas(unsigned flag) const {
+    return std::any_of(region.begin(), region.end(),
+                       [&](const OpenElement &e) { return e.flags & flag; });
+  }
+
+  // A start tag inside a root. Anything that would make Gumbo close or move
+  // elements implicitly gives the page up.
+  bool regionStart() {
+    const unsigned flags = tagFlags(tagName);
+    GumboNode *parent = region.back().node;
+    if (inForeign()) {
+      if (flags & (BreaksForeign | IntegrationPoint)) {
+        return false;
+      }
+      return openRegionElement(parent, GUMBO_NAMESPACE_SVG,
+                               flags | InForeign, !selfClosing);
+    }
+    if (flags & Template) {
+      // Built without its content: the parsers skip template nodes
+      GumboNode *node = newElement(parent, GUMBO_NAMESPACE_HTML);
+      if (!node) {
+        return false;
+      }
+      node->type = GUMBO_NODE_TEMPLATE;
+      return skipTemplate();
+    }
+    if (flags & KeptRawText) {
+      return addRawText(flags);
+    }
+    if (flags & (Unsupported | RawText | Plaintext)) {
+      return false;
+    }
+    if (flags & Foreign) { // svg; math is unsupported
+      return openRegionElement(parent, GUMBO_NAMESPACE_SVG, flags | InForeign,
+                               !selfClosing);
+    }
+    if ((flags & (Anchor | Button)) && regionHas(flags & (Anchor | Button))) {
+      return false;
+    }
+
+    // The elements this start tag closes first, as long as that stays
+    // inside the root and closes no formatting element
+    if (flags & ClosesP) {
+      size_t paragraph = std::string::npos;
+      for (size_t i = region.size(); i-- > 0;) {
+        if (region[i].flags & (Paragraph | Scope)) {
+          paragraph = region[i].flags & Paragraph ? i : paragraph;
+          break;
+        }
+        if (i == 0 && paragraphAround) {
+          return false;
+        }
+      }
+      if (paragraph != std::string::npos && !closeRegionTo(paragraph)) {
+        return false;
+      }
+    }
+    if (flags & (ListItem | DefItem)) {
+      const unsigned kind = flags & (ListItem | DefItem);
+      for (size_t i = region.size(); i-- > 0;) {
+        if (region[i].flags & kind) {
+          if (!closeRegionTo(i)) {
+            return false;
+          }
+          break;
+        }
+        if ((region[i].flags & Special) && !(region[i].flags & ListExempt)) {
+          break;
+        }
+        if (i == 0) {
+          return false; // the search would go on outside the root
+        }
+      }
+    }
+    if ((flags & Heading) && (region.back().flags & Heading) &&
+        !closeRegionTo(region.size() - 1)) {
+      return false;
+    }
+    return openRegionElement(region.back().node, GUMBO_NAMESPACE_HTML, flags,
+                             !(flags & Void));
+  }
+
+  // Closes region[index] and everything inside it
+  bool closeRegionTo(size_t index) {
+    if (index == 0 ||
+        std::any_of(region.begin() + index, region.end(),
+                    [](const OpenElement &e) {
+                      return (e.flags & Formatting) != 0;
+                    })) {
+      return false;
+    }
+    region.resize(index);
+    return true;
+  }
+
+  bool openRegionElement(GumboNode *parent, GumboNamespaceEnum ns,
+                         unsigned flags, bool push) {
+    GumboNode *node = newElement(parent, ns);
+    if (!node) {
+      return false;
+    }
+    if (push) {
+      region.push_back({std::string(tagName), flags, node});
+    }
+    return true;
+  }
+
+  // The end tag must close the element on top, or for a special element,
+  // the nearest one below li, dd, dt and p elements it closes implicitly.
+  // Anything else means Gumbo ignores the tag or restructures the tree.
+  bool regionEnd() {
+    size_t target = region.size() - 1;
+    if (tagFlags(tagName) & Special) {
+      while (target > 0 && region[target].name != tagName &&
+             (region[target].flags & ImpliedEnd) &&
+             !(region[target].flags & InForeign)) {
+        --target;
+      }
+    }
+    if (region[target].name != tagName) {
+      return false;
+    }
+    GumboNode *node = region[target].node;
+    region.resize(target);
+    if (region.empty()) {
+      found(node);
+    }
+    return true;
+  }
+
+  bool flushText(size_t start, size_t end) {
+    return start >= end ||
+           addText(GUMBO_NODE_TEXT, in.substr(start, end - start),
+                   Context::Text);
+  }
+
+  // Adds raw, decoded, to the element on top. Text that is only whitespace
+  // becomes a whitespace node, like in Gumbo; empty text adds nothing.
+  bool addText(GumboNodeType type, std::string_view raw, Context context) {
+    textBuffer.clear();
+    bool whitespace = true;
+    if (!appendDecoded(raw, context, textBuffer, whitespace)) {
+      return false;
+    }
+    if (textBuffer.empty() && type != GUMBO_NODE_COMMENT) {
+      return true;
+    }
+    if (whitespace && type == GUMBO_NODE_TEXT) {
+      type = GUMBO_NODE_WHITESPACE;
+    }
+    GumboNode *node = newNode(type, region.back().node);
+    node->v.text.text = copyString(textBuffer);
+    return true;
+  }
+
+  bool addComment() {
+    return addText(GUMBO_NODE_COMMENT, comment, Context::Raw);
+  }
+
+  GumboNode *newNode(GumboNodeType type, GumboNode *parent) {
+    auto *node = static_cast<GumboNode *>(arena.allocate(sizeof(GumboNode)));
+    std::memset(node, 0, sizeof(GumboNode));
+    node->type = type;
+    node->parent = parent;
+    if (parent) {
+      GumboVector &children = parent->v.element.children;
+      node->index_within_parent = children.length;
+      append(children, node);
+    }
+    return node;
+  }
+
+  // The element for the current tag, with its attributes resolved; the
+  // first of several with the same name wins, as in Gumbo
+  GumboNode *newElement(GumboNode *parent, GumboNamespaceEnum ns) {
+    const size_t slots = std::max<size_t>(attributes.size(), 1);
+    auto **list =
+        static_cast<void **>(arena.allocate(slots * sizeof(void *)));
+    unsigned int count = 0;
+    for (auto raw = attributes.begin(); raw != attributes.end(); ++raw) {
+      const bool repeated =
+          std::any_of(attributes.begin(), raw, [&](const RawAttribute &a) {
+            return equalsLowercase(raw->name, a.name);
+          });
+      if (repeated) {
+        continue;
+      }
+      attributeName.clear();
+      bool whitespace = true;
+      if (!appendDecoded(raw->name, Context::Raw, attributeName, whitespace)) {
+        return nullptr;
+      }
+      for (auto &c : attributeName) {
+        c = toLower(c);
+      }
+      GumboAttributeNamespaceEnum attributeNamespace =
+          GUMBO_ATTR_NAMESPACE_NONE;
+      if (ns == GUMBO_NAMESPACE_SVG) {
+        for (const auto &foreign : kForeignAttributes) {
+          if (attributeName == foreign.name) {
+            attributeName.assign(foreign.localName);
+            attributeNamespace = foreign.attributeNamespace;
+            break;
+          }
+        }
+        for (auto mixed : kSvgAttributes) {
+          if (equalsLowercase(mixed, attributeName)) {
+            attributeName.assign(mixed);
+            break;
+          }
+        }
+      }
+      valueBuffer.clear();
+      if (!appendDecoded(raw->value, Context::Attribute, valueBuffer,
+                         whitespace)) {
+        return nullptr;
+      }
+      auto *attribute = static_cast<GumboAttribute *>(
+          arena.allocate(sizeof(GumboAttribute)));
+      std::memset(attribute, 0, sizeof(GumboAttribute));
+      attribute->attr_namespace = attributeNamespace;
+      attribute->name = copyString(attributeName);
+      attribute->value = copyString(valueBuffer);
+      list[count++] = attribute;
+    }
+
+    GumboNode *node = newNode(GUMBO_NODE_ELEMENT, parent);
+    GumboElement &element = node->v.element;
+    element.tag = gumbo_tagn_enum(tagName.data(),
+                                  static_cast<unsigned int>(tagName.size()));
+    element.tag_namespace = ns;
+    element.attributes.data = list;
+    element.attributes.length = count;
+    element.attributes.capacity =
+        static_cast<unsigned int>(std::max<size_t>(attributes.size(), 1));
+    return node;
+  }
+
+  void append(GumboVector &vector, void *item) {
+    if (vector.length == vector.capacity) {
+      const unsigned int capacity = vector.capacity ? vector.capacity * 2 : 4;
+      auto **data =
+          static_cast<void **>(arena.allocate(capacity * sizeof(void *)));
+      std::copy(vector.data, vector.data + vector.length, data);
+      vector.data = data;
+      vector.capacity = capacity;
+    }
+    vector.data[vector.length++] = item;
+  }
+
+  const char *copyString(const std::string &s) {
+    auto *copy = static_cast<char *>(arena.allocate(s.size() + 1));
+    std::memcpy(copy, s.c_str(), s.size() + 1);
+    return copy;
+  }
+
+  std::string_view in;
+  bool (*isRoot)(const char *);
+  const std::function<void(GumboNode *)> &found;
+  GumboArena &arena;
+
+  size_t pos = 0;
+  bool done = false; // the rest of the page is text
+
+  std::string_view comment; // the text of the comment just read
+
+  // The tag just read
+  std::string_view tagName; // lowercase
+  std::vector<RawAttribute> attributes;
+  bool selfClosing = false;
+
+  std::vector<OpenElement> open;   // outside a root
+  std::vector<OpenElement> region; // inside one, the root first
+  bool strayFormatting = false;
+  bool paragraphAround = false; // a <p> was open around the root
+
+  std::string nameBuffer; // tagName, when it had to be lowercased
+  std::string attributeName;
+  std::string valueBuffer;
+  std::string textBuffer;
+};
+
+bool scannerEnabled = false;
+
+} // namespace
+
+bool scanElements(const std::string &html,
+                  bool (*isRoot)(const char *classAttr),
+                  const std::function<void(GumboNode *root)> &found) {
+  ArenaLease lease;
+  // Up to the first NUL, like gumbo_parse
+  Scanner scanner(html.c_str(), isRoot, found, lease.arena());
+  return scanner.run();
+}
+
+void setTagScanner(bool enabled) { scannerEnabled = enabled; }
+
+bool tagScannerEnabled() { return scannerEnabled; }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ArchivedPage {
+  std::string url;
+  PropertyType type;
+  bool betri; // otherwise Skyn
+  std::string html;
+};
+
+bool scanPage(const ArchivedPage &page, std::vector<RawProperty> &out) {
+  return page.betri ? BETRI::scanBetriPage(page.html, page.type, out)
+                    : SKYN::scanSkynPage(page.html, page.type, out);
+}
+
+std::vector<RawProperty> parsePageWithGumbo(const ArchivedPage &page) {
+  return page.betri ? BETRI::parseBetriWithGumbo(page.html, page.type)
+                    : SKYN::parseSkynWithGumbo(page.html, page.type);
+}
+
+// What the parsers do with the scanner on
+std::vector<RawProperty> parsePage(const ArchivedPage &page) {
+  std::vector<RawProperty> properties;
+  return scanPage(page, properties) ? properties : parsePageWithGumbo(page);
+}
+
+void appendEscaped(std::string &out, const char *text) {
+  for (; *text; ++text) {
+    switch (*text) {
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      out += *text;
+      break;
+    }
+  }
+}
+
+// One line per node, in document order, in the format
+// tools/scannerOracle.py writes for html5lib's tree. Tags Gumbo does not
+// know are written as "?"; template contents are left out.
+void describeNode(const GumboNode *node, std::string &out) {
+  switch (node->type) {
+  case GUMBO_NODE_ELEMENT:
+  case GUMBO_NODE_TEMPLATE: {
+    const GumboElement &element = node->v.element;
+    const bool isTemplate = node->type == GUMBO_NODE_TEMPLATE;
+    const char *tag = gumbo_normalized_tagname(element.tag);
+    const unsigned int children = isTemplate ? 0 : element.children.length;
+    out += isTemplate ? "M " : "E ";
+    out += std::to_string(element.tag_namespace) + " " + (*tag ? tag : "?") +
+           " " + std::to_string(element.attributes.length) + " " +
+           std::to_string(children) + "\n";
+    for (unsigned int i = 0; i < element.attributes.length; ++i) {
+      const auto *attribute =
+          static_cast<const GumboAttribute *>(element.attributes.data[i]);
+      out += "A " + std::to_string(attribute->attr_namespace) + " ";
+      appendEscaped(out, attribute->name);
+      out += "\t";
+      appendEscaped(out, attribute->value);
+      out += "\n";
+    }
+    for (unsigned int i = 0; i < children; ++i) {
+      describeNode(static_cast<const GumboNode *>(element.children.data[i]),
+                   out);
+    }
+    return;
+  }
+  case GUMBO_NODE_WHITESPACE:
+    out += "W ";
+    break;
+  case GUMBO_NODE_COMMENT:
+    out += "C ";
+    break;
+  default:
+    out += "T ";
+    break;
+  }
+  appendEscaped(out, node->v.text.text);
+  out += "\n";
+}
+
+// The elements isRoot picks out of a Gumbo tree, as the scanner finds them
+void describeRoots(const GumboNode *node, bool (*isRoot)(const char *),
+                   std::string &out) {
+  if (!node || node->type != GUMBO_NODE_ELEMENT) {
+    return;
+  }
+  const GumboVector &children = node->v.element.children;
+  const GumboAttribute *classAttr =
+      gumbo_get_attribute(&node->v.element.attributes, "class");
+  if (classAttr && isRoot(classAttr->value)) {
+    out += "R\n";
+    describeNode(node, out);
+    return;
+  }
+  for (unsigned int i = 0; i < children.length; ++i) {
+    describeRoots(static_cast<const GumboNode *>(children.data[i]), isRoot,
+                  out);
+  }
+}
+
+// The archive may hold no Skyn page, so a listing shaped like theirs is
+// always among the pages the random edits are made to
+const char kSkynListing[] =
+    "<!DOCTYPE html><html><body><div class=container>"
+    "<div class=\"row ognlist\">\n"
+    "<div class=\"ogn col-4\"><a href=\"/o/1\"><img src=\"/admin/public/"
+    "getimage.ashx?image=/a.jpg&amp;w=400\"></a>"
+    "<div class=\"ogn_headline\">V&aacute;gsvegur 12</div>"
+    "<div class=\"ogn_adress\">100 T&oacute;rshavn</div>"
+    "<ul><li><i class=\"prop-size\"></i> 140 m&sup2;</li>"
+    "<li><i class=\"prop-ground\"></i> 500 m\xc2\xb2</li>"
+    "<li><i class=\"prop-bedrooms\"></i> 4</li>"
+    "<li><i class=\"prop-floors\"></i> 2</li></ul>"
+    "<span class=\"listprice\">1.450.000</span> "
+    "<span class=\"latestoffer\">1.500.000</span>"
+    "<span class=\"validto\">12.12.2026 kl. 12</span></div>\n"
+    "<script>show()</script>\n"
+    "<div class=\"ogn col-4\"><div class=\"ogn_headline\">Bakkin 3</div>"
+    "<span class=\"listprice\">900.000</span></div>\n"
+    "</div></div></body></html>";
+
+// Markup the edits insert: the things the scanner gives up on, the things
+// it has to get exactly right, and broken pieces of both
+const char *const kEdits[] = {
+    "<p>", "</p>", "<b>", "</b>", "<i>x</i>", "<table>", "<td>", "<tr>",
+    "</td>", "&amp;", "&copy", "&copy;", "&notin;", "&#x80;", "&#0;", "&#65",
+    "&#x1F600;", "&nbsp;", "&amp", "&ampx", "&lt=", "&#xD800;", "&frac12x",
+    "<!-- x -->", "<!-->", "<!--->", "<!-- a -- b --!>", "<!x>", "<?pi>",
+    "<template><p>t</p></template>", "<svg viewbox='0 0 1 1' xlink:href=x>"
+    "<path d=1/></svg>", "<svg><foreignObject><div>x</div></foreignObject>"
+    "</svg>", "<svg><![CDATA[x<y]]></svg>", "<math><mi>x</mi></math>",
+    "<li>", "</li>", "<a href=x>", "</a>", "<a><a>", "<br/>", "<wbr>",
+    "\r\n", "\r", "\t", "\f", "  ", "<script>var a='</div>';</script>",
+    "<style>p{}</style>", "<div>", "</div>", "<h2>", "</h2>", "<button>",
+    "<select>", "<form>", "<textarea>t</textarea>", "<plaintext>", "<pre>",
+    "<hr>", "<input type=hidden>", "<ul>", "</ul>", "<dd>", "<dt>", "<nobr>",
+    "<font color=red>", "<p><b>x</p>", "<b><div>x</b>", "</article>",
+    "<span class=\"c\">s</span>", "<span a=1 a=2 A='3'>x</span>",
+    "<IMG SRC=b.jpg CLASS=x>", "<div =a b c= d>", "<span / a / >t</span>",
+    "<img src='x.jpg?a=1&copy=2&amp;b' alt=>", "<x-y>", "</ x>", "</>",
+    "\"", "'", "<", ">", "&", "=", "\xc3\xa9", "\xe2\x82\xac", "\xff",
+    "\x01", "\xed\xa0\x80", "\xef\xbf\xbe", "\xc2\xa0",
+};
+
+// One to three edits, half of them within a few KB after one of marks
+void editPage(std::string &html, const std::vector<size_t> &marks,
+              std::mt19937 &rng) {
+  const size_t edits = 1 + rng() % 3;
+  for (size_t e = 0; e < edits; ++e) {
+    size_t at = rng() % (html.size() + 1);
+    if (!marks.empty() && rng() % 2 == 0) {
+      at = std::min(html.size(), marks[rng() % marks.size()] + rng() % 4096);
+    }
+    const unsigned kind = rng() % 10;
+    if (kind < 7) {
+      html.insert(at, kEdits[rng() % std::size(kEdits)]);
+    } else if (kind < 9) {
+      html.erase(at, rng() % 40);
+    } else if (!html.empty()) {
+      html.insert(at, html.substr(rng() % html.size(), rng() % 80));
+    }
+  }
+}
+
+} // namespace
+
+int verifyTagScanner(const std::string &rawHtmlDir, size_t count,
+                     unsigned seed, const std::string &dumpDir) {
+  std::vector<ArchivedPage> pages;
+  std::unordered_set<std::string> seenHashes;
+  size_t betriPages = 0;
+  for (const auto &record : archivedSnapshotRecords(rawHtmlDir)) {
+    const bool betri = record.url.find("betriheim") != std::string::npos;
+    const bool skyn = record.url.find("skyn") != std::string::npos;
+    if (record.unchanged || !(betri || skyn) ||
+        !seenHashes.insert(record.hash).second) {
+      continue;
+    }
+    ArchivedPage page{record.url,
+                      PropertyManager::stringToPropertyType(record.type),
+                      betri, ""};
+    if (loadSnapshotPage(rawHtmlDir, record, page.html)) {
+      betriPages += betri ? 1 : 0;
+      pages.push_back(std::move(page));
+    }
+  }
+  if (pages.empty()) {
+    std::cerr << "No archived Betri or Skyn pages in " << rawHtmlDir << "\n";
+    return 1;
+  }
+
+  size_t properties = 0;
+  size_t leftToGumbo = 0;
+  size_t mismatches = 0;
+  for (const auto &page : pages) {
+    const auto expected = parsePageWithGumbo(page);
+    properties += expected.size();
+    std::vector<RawProperty> scanned;
+    if (!scanPage(page, scanned)) {
+      ++leftToGumbo;
+    } else if (describeRawProperties(scanned) !=
+               describeRawProperties(expected)) {
+      if (mismatches++ == 0) {
+        std::cerr << "The scanner and Gumbo differ on " << page.url << "\n";
+      }
+    }
+  }
+
+  // About 200 pages each way, at least one pass
+  const size_t rounds = std::max<size_t>(1, 200 / pages.size());
+  auto start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r) {
+    for (const auto &page : pages) {
+      parsePageWithGumbo(page);
+    }
+  }
+  const double gumboSeconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  start = Clock::now();
+  for (size_t r = 0; r < rounds; ++r) {
+    for (const auto &page : pages) {
+      parsePage(page);
+    }
+  }
+  const double scannerSeconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  const double parses = static_cast<double>(rounds * pages.size());
+  const double gumboUs = gumboSeconds * 1e6 / parses;
+  const double scannerUs = scannerSeconds * 1e6 / parses;
+  char line[160];
+  std::snprintf(line, sizeof(line),
+                "%zu distinct pages (%zu Betri, %zu Skyn), %zu properties\n",
+                pages.size(), betriPages, pages.size() - betriPages,
+                properties);
+  std::cout << line;
+  std::snprintf(line, sizeof(line), "%zu pages left to Gumbo\n", leftToGumbo);
+  std::cout << line;
+  std::snprintf(line, sizeof(line), "Gumbo:   %.0f us per page\n", gumboUs);
+  std::cout << line;
+  std::snprintf(line, sizeof(line), "Scanner: %.0f us per page\n",
+                scannerUs);
+  std::cout << line;
+  if (mismatches != 0) {
+    std::cerr << mismatches << " pages parsed differently\n";
+    return 1;
+  }
+
+  // The edits are made to plain pages: old snapshots that stored Betri's
+  // JSON payload would only have their JSON broken
+  std::vector<ArchivedPage> bases;
+  for (const auto &page : pages) {
+    const size_t first = page.html.find_first_not_of(" \t\r\n");
+    if (first != std::string::npos && page.html[first] != '{') {
+      bases.push_back(page);
+    }
+  }
+  bases.push_back({"synthetic Skyn listing", PropertyType::Sethus, false,
+                   kSkynListing});
+  std::vector<std::vector<size_t>> marks(bases.size());
+  for (size_t b = 0; b < bases.size(); ++b) {
+    const char *marker = bases[b].betri ? "c-property c-card" : "ognlist";
+    for (size_t at = bases[b].html.find(marker); at != std::string::npos;
+         at = bases[b].html.find(marker, at + 1)) {
+      marks[b].push_back(at);
+    }
+  }
+  if (!dumpDir.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(dumpDir, ec);
+    if (ec) {
+      std::cerr << "Cannot create " << dumpDir << ": " << ec.message() << "\n";
+      return 1;
+    }
+  }
+
+  std::mt19937 rng(seed);
+  size_t edited = 0;
+  size_t gaveUp = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const size_t b = rng() % bases.size();
+    ArchivedPage page = bases[b];
+    editPage(page.html, marks[b], rng);
+    auto *isRoot = page.betri ? BETRI::isBetriCard : SKYN::isSkynList;
+    ++edited;
+
+    std::string scanned;
+    const bool read = scanElements(page.html, isRoot, [&](GumboNode *root) {
+      scanned += "R\n";
+      describeNode(root, scanned);
+    });
+    if (!read) {
+      ++gaveUp;
+      continue;
+    }
+    std::string expected;
+    {
+      GumboDocument document(page.html);
+      describeRoots(document.root(), isRoot, expected);
+    }
+    std::vector<RawProperty> properties;
+    scanPage(page, properties);
+    const bool sameProperties = describeRawProperties(properties) ==
+                                describeRawProperties(parsePageWithGumbo(page));
+    if (scanned != expected || !sameProperties) {
+      if (mismatches++ == 0) {
+        std::cerr << "The scanner and Gumbo differ on edit " << i << " of "
+                  << page.url << "\n";
+      }
+    }
+    if (!dumpDir.empty()) {
+      const std::string name = dumpDir + "/" + std::to_string(i);
+      std::ofstream(name + ".html", std::ios::binary)
+          << page.html.c_str(); // up to the first NUL, as both parsed it
+      std::ofstream(name + ".roots", std::ios::binary)
+          << (page.betri ? "betri\n" : "skyn\n") << scanned;
+    }
+  }
+  std::snprintf(line, sizeof(line),
+                "%zu edited pages, %zu left to Gumbo, %zu built differently\n",
+                edited, gaveUp, mismatches);
+  std::cout << line;
+
+  if (mismatches != 0) {
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace HT
@@ -0,0 +1,419 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <regex>
+#include <scrapers/include/PropertyManager.hpp>
+#include <scrapers/include/snapshotManifest.hpp>
+#include <scrapers/include/textScan.hpp>
+#include <unordered_set>
+#include <vector>
+
+namespace HT {
+namespace {
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+         c == '\r';
+}
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// What . does not match
+bool isLineBreak(char c) { return c == '\n' || c == '\r'; }
+
+// Matches \s+(.+)$ against tail, with \s+ taking all it can and still
+// leaving (.+) a character
+bool splitAfterSpace(std::string_view tail, std::string_view &rest) {
+  size_t spaces = 0;
+  while (spaces < tail.size() && isSpace(tail[spaces])) {
+    ++spaces;
+  }
+  if (spaces == 0 || tail.size() < 2) {
+    return false;
+  }
+  const size_t start = spaces < tail.size() ? spaces : tail.size() - 1;
+  for (size_t i = start; i < tail.size(); ++i) {
+    if (isLineBreak(tail[i])) {
+      return false;
+    }
+  }
+  rest = tail.substr(start);
+  return true;
+}
+
+bool isPostCodeAt(std::string_view s, size_t pos) {
+  return pos + 3 < s.size() && isDigit(s[pos]) && isDigit(s[pos + 1]) &&
+         isDigit(s[pos + 2]);
+}
+
+} // namespace
+
+std::string collapseWhitespace(std::string_view s) {
+  std::string out;
+  out.reserve(s.size());
+  bool inSpace = false;
+  for (char c : s) {
+    if (isSpace(c)) {
+      if (!inSpace) {
+        out.push_back(' ');
+      }
+      inSpace = true;
+    } else {
+      out.push_back(c);
+      inSpace = false;
+    }
+  }
+  return out;
+}
+
+bool splitPostCode(std::string_view s, std::string_view &street,
+                   std::string_view &postNum, std::string_view &city) {
+  // (.*) cannot cross a line break, so the street ends at the first one
+  size_t firstBreak = 0;
+  while (firstBreak < s.size() && !isLineBreak(s[firstBreak])) {
+    ++firstBreak;
+  }
+
+  // (.*) is greedy: the last post code that fits wins
+  for (size_t pos = s.size() < 4 ? 0 : s.size() - 4; pos >= 1; --pos) {
+    if (!isSpace(s[pos - 1]) || !isPostCodeAt(s, pos)) {
+      continue;
+    }
+    size_t runStart = pos - 1;
+    while (runStart > 0 && isSpace(s[runStart - 1])) {
+      --runStart;
+    }
+    const size_t streetEnd = std::min(pos - 1, firstBreak);
+    std::string_view rest;
+    if (streetEnd < runStart || !splitAfterSpace(s.substr(pos + 3), rest)) {
+      continue;
+    }
+    street = s.substr(0, streetEnd);
+    postNum = s.substr(pos, 3);
+    city = rest;
+    return true;
+  }
+  return false;
+}
+
+bool splitLeadingPostCode(std::string_view s, std::string_view &postNum,
+                          std::string_view &city) {
+  std::string_view rest;
+  if (!isPostCodeAt(s, 0) || !splitAfterSpace(s.substr(3), rest)) {
+    return false;
+  }
+  postNum = s.substr(0, 3);
+  city = rest;
+  return true;
+}
+
+std::string_view firstNumber(std::string_view s) {
+  size_t start = 0;
+  while (start < s.size() && !isDigit(s[start])) {
+    ++start;
+  }
+  size_t end = start;
+  while (end < s.size() &&
+         (isDigit(s[end]) || s[end] == '.' || s[end] == ',')) {
+    ++end;
+  }
+  return s.substr(start, end - start);
+}
+
+bool hasWord(std::string_view s, std::string_view word) {
+  size_t pos = 0;
+  while (pos < s.size()) {
+    while (pos < s.size() && isSpace(s[pos])) {
+      ++pos;
+    }
+    const size_t start = pos;
+    while (pos < s.size() && !isSpace(s[pos])) {
+      ++pos;
+    }
+    if (pos > start && s.substr(start, pos - start) == word) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string replaceAll(std::string_view s, std::string_view from,
+                       std::string_view to) {
+  if (from.empty()) {
+    return std::string(s);
+  }
+  std::string out;
+  out.reserve(s.size());
+  size_t pos = 0;
+  for (size_t hit = s.find(from); hit != std::string_view::npos;
+       hit = s.find(from, pos)) {
+    out.append(s.substr(pos, hit - pos));
+    out.append(to);
+    pos = hit + from.size();
+  }
+  out.append(s.substr(pos));
+  return out;
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Scan = std::function<std::string(const std::string &)>;
+
+// Each scanner next to the regex it replaced, both rendering what they
+// found as a string so the two can be compared. Splits come out as
+// "street|post|city", or "-" when the text does not match.
+
+const char *const kWord = "vegur"; // what hasWord looks for
+
+std::string regexCollapseWhitespace(const std::string &s) {
+  static const std::regex spaces("\\s+");
+  return std::regex_replace(s, spaces, " ");
+}
+
+std::string handCollapseWhitespace(const std::string &s) {
+  return collapseWhitespace(s);
+}
+
+std::string regexSplitPostCode(const std::string &s) {
+  static const std::regex postCode(R"(^(.*)\s+(\d{3})\s+(.+)$)");
+  std::smatch m;
+  if (!std::regex_match(s, m, postCode)) {
+    return "-";
+  }
+  return m[1].str() + "|" + m[2].str() + "|" + m[3].str();
+}
+
+std::string handSplitPostCode(const std::string &s) {
+  std::string_view street, postNum, city;
+  if (!splitPostCode(s, street, postNum, city)) {
+    return "-";
+  }
+  return std::string(street) + "|" + std::string(postNum) + "|" +
+         std::string(city);
+}
+
+std::string regexSplitLeadingPostCode(const std::string &s) {
+  static const std::regex leadingPostCode(R"(^(\d{3})\s+(.+)$)");
+  std::smatch m;
+  if (!std::regex_match(s, m, leadingPostCode)) {
+    return "-";
+  }
+  return m[1].str() + "|" + m[2].str();
+}
+
+std::string handSplitLeadingPostCode(const std::string &s) {
+  std::string_view postNum, city;
+  if (!splitLeadingPostCode(s, postNum, city)) {
+    return "-";
+  }
+  return std::string(postNum) + "|" + std::string(city);
+}
+
+std::string regexFirstNumber(const std::string &s) {
+  static const std::regex number(R"((\d[\d\.,]*))");
+  std::smatch m;
+  return std::regex_search(s, m, number) ? m[1].str() : "";
+}
+
+std::string handFirstNumber(const std::string &s) {
+  return std::string(firstNumber(s));
+}
+
+std::string regexHasWord(const std::string &s) {
+  static const std::regex word(std::string("(^|\\s)") + kWord + "(\\s|$)");
+  return std::regex_search(s, word) ? "1" : "0";
+}
+
+std::string handHasWord(const std::string &s) {
+  return hasWord(s, kWord) ? "1" : "0";
+}
+
+// As the regex parser joins quoted cells
+std::string regexReplaceAll(const std::string &s) {
+  static const std::regex quotes(R"("")");
+  return std::regex_replace(s, quotes, ", ");
+}
+
+std::string handReplaceAll(const std::string &s) {
+  return replaceAll(s, "\"\"", ", ");
+}
+
+struct ScanPair {
+  const char *name;
+  Scan regexScan;
+  Scan handScan;
+};
+
+const std::vector<ScanPair> &scanPairs() {
+  static const std::vector<ScanPair> pairs = {
+      {"collapseWhitespace", regexCollapseWhitespace, handCollapseWhitespace},
+      {"splitPostCode", regexSplitPostCode, handSplitPostCode},
+      {"splitLeadingPostCode", regexSplitLeadingPostCode,
+       handSplitLeadingPostCode},
+      {"firstNumber", regexFirstNumber, handFirstNumber},
+      {"hasWord", regexHasWord, handHasWord},
+      {"replaceAll", regexReplaceAll, handReplaceAll},
+  };
+  return pairs;
+}
+
+volatile size_t scannedBytes = 0; // keeps the timed calls from being elided
+
+// Nanoseconds per call of scan over rounds passes through inputs
+double timeScan(const std::vector<std::string> &inputs, size_t rounds,
+                const Scan &scan) {
+  const auto start = Clock::now();
+  size_t bytes = 0;
+  for (size_t r = 0; r < rounds; ++r) {
+    for (const auto &input : inputs) {
+      bytes += scan(input).size();
+    }
+  }
+  scannedBytes = bytes;
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  return seconds * 1e9 / static_cast<double>(rounds * inputs.size());
+}
+
+// Prints one line of the table; false if the scanner and the regex
+// disagree on an input
+bool compare(const char *name, const std::vector<std::string> &inputs,
+             const Scan &regexScan, const Scan &handScan) {
+  if (inputs.empty()) {
+    return true;
+  }
+  size_t mismatches = 0;
+  for (const auto &input : inputs) {
+    if (regexScan(input) != handScan(input)) {
+      if (mismatches++ == 0) {
+        std::cerr << name << " differs on \"" << input << "\"\n";
+      }
+    }
+  }
+
+  // About 200k calls each, at least one pass
+  const size_t rounds = std::max<size_t>(1, 200000 / inputs.size());
+  const double regexNs = timeScan(inputs, rounds, regexScan);
+  const double handNs = timeScan(inputs, rounds, handScan);
+  char line[128];
+  std::snprintf(line, sizeof(line), "%-22s %7zu %10.0f %10.0f %8.1fx", name,
+                inputs.size(), regexNs, handNs,
+                handNs > 0 ? regexNs / handNs : 0.0);
+  std::cout << line << "\n";
+  return mismatches == 0;
+}
+
+} // namespace
+
+int benchTextScan(const std::string &rawHtmlDir) {
+  // What the parsers found in every distinct archived page
+  std::vector<std::string> addresses; // "<street>\n  <post>  <city>"
+  std::vector<std::string> cities;    // as the parsers found them
+  std::vector<std::string> sizes;     // "Stødd á bygningi 122 m2"
+  std::unordered_set<std::string> seenHashes;
+  for (const auto &record : archivedSnapshotRecords(rawHtmlDir)) {
+    if (!seenHashes.insert(record.hash).second) {
+      continue;
+    }
+    std::string page;
+    if (!loadSnapshotPage(rawHtmlDir, record, page)) {
+      continue;
+    }
+    for (const auto &raw : parseSnapshotHtml(record, page)) {
+      // Laid out over two lines, as on a Betri card
+      std::string address = raw.address;
+      if (!raw.postNum.empty()) {
+        address += "\n  " + raw.postNum;
+      }
+      if (!raw.city.empty()) {
+        address += "  " + raw.city;
+      }
+      addresses.push_back(std::move(address));
+      cities.push_back(raw.city);
+      for (const auto *size : {&raw.buildingSize, &raw.landSize}) {
+        if (!size->empty()) {
+          sizes.push_back(*size);
+        }
+      }
+    }
+  }
+  if (addresses.empty()) {
+    std::cerr << "No parsed properties in " << rawHtmlDir << "\n";
+    return 1;
+  }
+
+  std::vector<std::string> collapsed;
+  std::vector<std::string> postCities;
+  for (const auto &address : addresses) {
+    collapsed.push_back(collapseWhitespace(address));
+    std::string_view street, postNum, city;
+    if (splitPostCode(collapsed.back(), street, postNum, city)) {
+      postCities.push_back(std::string(postNum) + " " + std::string(city));
+    }
+  }
+  postCities.insert(postCities.end(), cities.begin(), cities.end());
+
+  std::cout << "scanner                  calls   regex ns    hand ns  speedup\n";
+  bool same = true;
+  same &= compare("collapseWhitespace", addresses, regexCollapseWhitespace,
+                  handCollapseWhitespace);
+  same &= compare("splitPostCode", collapsed, regexSplitPostCode,
+                  handSplitPostCode);
+  same &= compare("splitLeadingPostCode", postCities,
+                  regexSplitLeadingPostCode, handSplitLeadingPostCode);
+  same &= compare("firstNumber", sizes, regexFirstNumber, handFirstNumber);
+  same &= compare("hasWord", collapsed, regexHasWord, handHasWord);
+
+  if (!same) {
+    std::cerr << "Scanners disagree with the regexes they replace\n";
+    return 1;
+  }
+  return 0;
+}
+
+int verifyTextScan(size_t count, unsigned seed) {
+  // Short strings of the pieces the patterns care about, so that every
+  // branch of every scanner is reached many times over. Half of them may
+  // hold a NUL, which std::regex treats as an ordinary character.
+  const std::string pieces[] = {
+      " ", "\t", "\n", "\r", "\v", "\f", "1", "2", "3",  "4",
+      "a", "b",  ".",  ",",  "\"", kWord, std::string(1, '\0')};
+  const size_t withoutNul = std::size(pieces) - 1;
+
+  std::mt19937 rng(seed);
+  std::vector<size_t> mismatches(scanPairs().size());
+  for (size_t i = 0; i < count; ++i) {
+    const size_t length = rng() % 14;
+    const size_t alphabet = i % 2 ? std::size(pieces) : withoutNul;
+    std::string input;
+    for (size_t k = 0; k < length; ++k) {
+      input += pieces[rng() % alphabet];
+    }
+    for (size_t p = 0; p < scanPairs().size(); ++p) {
+      const ScanPair &pair = scanPairs()[p];
+      if (pair.regexScan(input) != pair.handScan(input) &&
+          mismatches[p]++ == 0) {
+        std::cerr << pair.name << " differs on \"" << input << "\"\n";
+      }
+    }
+  }
+
+  bool same = true;
+  for (size_t p = 0; p < scanPairs().size(); ++p) {
+    std::cout << scanPairs()[p].name << ": " << mismatches[p] << " of "
+              << count << " inputs differ\n";
+    same &= mismatches[p] == 0;
+  }
+  if (!same) {
+    std::cerr << "Scanners disagree with the regexes they replace\n";
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace HT
@@ -0,0 +1,89 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <scrapers/include/validatorStore.hpp>
+
+namespace HT {
+
+ValidatorStore::ValidatorStore(std::string path) : path(std::move(path)) {}
+
+bool ValidatorStore::load() {
+  byUrl.clear();
+  std::ifstream ifs(path);
+  if (!ifs.is_open()) {
+    return false; // first run, nothing stored yet
+  }
+
+  try {
+    nlohmann::json j;
+    ifs >> j;
+    for (auto &[url, entry] : j.items()) {
+      Validators v;
+      v.etag = entry.value("etag", "");
+      v.lastModified = entry.value("lastModified", "");
+      v.snapshot = entry.value("snapshot", "");
+      byUrl[url] = std::move(v);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Ignoring unreadable " << path << ": " << e.what() << "\n";
+    byUrl.clear();
+    return false;
+  }
+  return true;
+}
+
+bool ValidatorStore::save() const {
+  nlohmann::json j = nlohmann::json::object();
+  for (const auto &[url, v] : byUrl) {
+    j[url] = {{"etag", v.etag},
+              {"lastModified", v.lastModified},
+              {"snapshot", v.snapshot}};
+  }
+
+  // Written aside and renamed, so a crash never leaves half the validators
+  const std::string tmpPath = path + ".tmp";
+  std::error_code ec;
+  {
+    std::ofstream ofs(tmpPath);
+    if (!ofs.is_open()) {
+      std::cerr << "Failed to open " << tmpPath << " for writing!\n";
+      return false;
+    }
+    ofs << j.dump(4);
+    if (!ofs.flush()) {
+      std::cerr << "Failed to write " << tmpPath << "\n";
+      ofs.close();
+      std::filesystem::remove(tmpPath, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(tmpPath, path, ec);
+  if (ec) {
+    std::cerr << "Error renaming " << tmpPath << ": " << ec.message() << "\n";
+    std::filesystem::remove(tmpPath, ec);
+    return false;
+  }
+  return true;
+}
+
+const Validators *ValidatorStore::find(const std::string &url) const {
+  auto it = byUrl.find(url);
+  if (it == byUrl.end()) {
+    return nullptr;
+  }
+  const Validators &v = it->second;
+  if (v.etag.empty() && v.lastModified.empty()) {
+    return nullptr;
+  }
+  if (v.snapshot.empty() || !std::filesystem::exists(v.snapshot)) {
+    return nullptr;
+  }
+  return &v;
+}
+
+void ValidatorStore::update(const std::string &url, Validators validators) {
+  byUrl[url] = std::move(validators);
+}
+
+} // namespace HT
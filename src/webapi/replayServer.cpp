@@ -0,0 +1,172 @@
+#include <drogon/drogon.h>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <scrapers/include/blobStore.hpp>
+#include <scrapers/include/fetchEngine.hpp>
+#include <scrapers/include/filesystem.hpp>
+#include <scrapers/include/hash.hpp>
+#include <string>
+#include <unordered_map>
+#include <webapi/replayServer.hpp>
+
+namespace HT {
+
+using namespace drogon;
+
+namespace {
+
+struct ReplayPage {
+  std::string url;
+  long long timestamp = -1;
+  std::string hash;
+  std::string body;
+};
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// Requests and archived urls are compared decoded, so it does not matter
+// whether the HTTP layer hands over the path escaped or not
+std::string percentDecode(const std::string &input) {
+  std::string out;
+  out.reserve(input.size());
+  for (size_t i = 0; i < input.size(); ++i) {
+    if (input[i] == '%' && i + 2 < input.size() &&
+        hexValue(input[i + 1]) >= 0 && hexValue(input[i + 2]) >= 0) {
+      out += static_cast<char>(hexValue(input[i + 1]) * 16 +
+                               hexValue(input[i + 2]));
+      i += 2;
+    } else {
+      out += input[i];
+    }
+  }
+  return out;
+}
+
+// Newest stored body of every url, keyed by its decoded replay path
+std::unordered_map<std::string, ReplayPage>
+loadReplayPages(const std::string &rawHtmlDir) {
+  std::unordered_map<std::string, ReplayPage> pages;
+
+  for (const auto &path : gatherJsonFiles(rawHtmlDir)) {
+    nlohmann::json j;
+    {
+      std::ifstream ifs(path);
+      try {
+        ifs >> j;
+      } catch (...) {
+        continue;
+      }
+    }
+    if (j.value("unchanged", false) || !j.contains("url")) {
+      continue; // 304 markers carry no page
+    }
+
+    const std::string url = j.value("url", "");
+    const long long timestamp = j.value("timestamp", 0LL);
+    ReplayPage &page = pages[percentDecode(replayPathForUrl(url))];
+    if (timestamp < page.timestamp) {
+      continue;
+    }
+    page.url = url;
+    page.timestamp = timestamp;
+    page.hash.clear();
+    page.body.clear();
+    if (j.contains("hash") && j["hash"].is_string()) {
+      page.hash = j["hash"].get<std::string>();
+    } else if (j.contains("html") && j["html"].is_string()) {
+      page.body = j["html"].get<std::string>();
+      page.hash = sha256Hex(page.body);
+    }
+  }
+
+  // Only the winning snapshots get their bodies loaded
+  for (auto it = pages.begin(); it != pages.end();) {
+    ReplayPage &page = it->second;
+    if (page.body.empty() && !page.hash.empty()) {
+      loadBlob(rawHtmlDir, page.hash, page.body);
+    }
+    if (page.body.empty()) {
+      it = pages.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return pages;
+}
+
+} // namespace
+
+void runReplayServer(const ReplayOptions &options) {
+  using PageMap = std::unordered_map<std::string, ReplayPage>;
+  auto pages =
+      std::make_shared<const PageMap>(loadReplayPages("../src/raw_html"));
+  for (const auto &[key, page] : *pages) {
+    std::cout << "Replaying " << page.url << " (" << page.body.size()
+              << " bytes)\n";
+  }
+  std::cout << "Replay server on http://127.0.0.1:" << options.port << " with "
+            << pages->size() << " pages, " << options.latencyMs
+            << " ms latency, "
+            << (options.bandwidthKbps > 0
+                    ? std::to_string(options.bandwidthKbps) + " kbit/s"
+                    : std::string("unlimited bandwidth"))
+            << "\n";
+
+  app().registerHandlerViaRegex(
+      "/.*",
+      [pages, options](
+          const HttpRequestPtr &req,
+          std::function<void(const HttpResponsePtr &)> &&callback) {
+        std::string key = req->path();
+        if (!req->query().empty()) {
+          key += "?" + req->query();
+        }
+
+        auto resp = HttpResponse::newHttpResponse();
+        auto it = pages->find(percentDecode(key));
+        double delaySeconds = options.latencyMs / 1000.0;
+        if (it == pages->end()) {
+          resp->setStatusCode(k404NotFound);
+        } else {
+          const ReplayPage &page = it->second;
+          const std::string etag = "\"" + page.hash + "\"";
+          resp->addHeader("ETag", etag);
+          if (req->getHeader("if-none-match") == etag) {
+            resp->setStatusCode(k304NotModified);
+          } else {
+            resp->setContentTypeCode(CT_TEXT_HTML);
+            resp->setBody(page.body);
+            if (options.bandwidthKbps > 0) {
+              delaySeconds += page.body.size() * 8.0 /
+                              (options.bandwidthKbps * 1000.0);
+            }
+          }
+        }
+
+        // Delay on the event loop rather than sleeping, so concurrent
+        // requests overlap the way they would against a slow remote site
+        if (delaySeconds <= 0) {
+          callback(resp);
+          return;
+        }
+        app().getLoop()->runAfter(
+            delaySeconds,
+            [resp, callback = std::move(callback)]() { callback(resp); });
+      },
+      {Get});
+
+  app().addListener("127.0.0.1", static_cast<uint16_t>(options.port));
+  app().run();
+}
+
+} // namespace HT
@@ -0,0 +1,17 @@
+// replayServer.hpp
+#pragma once
+
+namespace HT {
+
+struct ReplayOptions {
+  int port = 8090;
+  int latencyMs = 0;     // added before every response
+  int bandwidthKbps = 0; // per response, 0 = unlimited
+};
+
+// Serves the newest archived raw_html snapshot of every scraped url from a
+// local endpoint, so `--scrape --download --replay http://127.0.0.1:<port>`
+// can be benchmarked without touching the live sites
+void runReplayServer(const ReplayOptions &options);
+
+} // namespace HT
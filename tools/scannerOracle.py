@@ -0,0 +1,142 @@
+# Checks the cards the tag scanner built against html5lib's tree of the same
+# page. Reads what `HouseTracker --verify-scanner --dump DIR` wrote: N.html,
+# an edited page, and N.roots, "betri" or "skyn" followed by the elements the
+# scanner built, one line per node.
+#
+#   python3 tools/scannerOracle.py DIR
+import os
+import sys
+
+import html5lib
+
+NAMESPACES = {'http://www.w3.org/1999/xhtml': 0,
+              'http://www.w3.org/2000/svg': 1,
+              'http://www.w3.org/1998/Math/MathML': 2}
+ATTRIBUTE_NAMESPACES = {'http://www.w3.org/1999/xlink': 1,
+                        'http://www.w3.org/XML/1998/namespace': 2,
+                        'http://www.w3.org/2000/xmlns/': 3}
+WHITESPACE = ' \t\n\f\r'
+
+
+def is_betri_card(cls):
+    return cls in ('c-property c-card grid', 'c-property c-card grid ')
+
+
+def is_skyn_list(cls):
+    return 'ognlist' in cls
+
+
+def escape(s):
+    return (s.replace('\\', '\\\\').replace('\n', '\\n')
+            .replace('\r', '\\r').replace('\t', '\\t'))
+
+
+def split_name(tag):
+    if tag.startswith('{'):
+        namespace, name = tag[1:].split('}', 1)
+        return namespace, name
+    return None, tag
+
+
+def children(element):
+    # Text and tails next to each other are one text node, as in Gumbo
+    nodes = []
+    if element.text:
+        nodes.append(element.text)
+    for child in element:
+        nodes.append(child)
+        if child.tail:
+            nodes.append(child.tail)
+    merged = []
+    for node in nodes:
+        if isinstance(node, str) and merged and isinstance(merged[-1], str):
+            merged[-1] += node
+        else:
+            merged.append(node)
+    return merged
+
+
+def describe(node, out):
+    if isinstance(node, str):
+        kind = 'W' if all(c in WHITESPACE for c in node) else 'T'
+        out.append(kind + ' ' + escape(node))
+        return
+    if not isinstance(node.tag, str):
+        out.append('C ' + escape(node.text or ''))
+        return
+    namespace, name = split_name(node.tag)
+    attributes = []
+    for key, value in node.attrib.items():
+        attribute_namespace, attribute_name = split_name(key)
+        attributes.append((ATTRIBUTE_NAMESPACES.get(attribute_namespace, 0),
+                           attribute_name, value))
+    ns = NAMESPACES.get(namespace, 0)
+    is_template = name == 'template' and ns == 0
+    nodes = [] if is_template else children(node)
+    out.append('%s %d %s %d %d' % ('M' if is_template else 'E', ns,
+                                   name.lower(), len(attributes), len(nodes)))
+    for attribute_namespace, attribute_name, value in attributes:
+        out.append('A %d %s\t%s' % (attribute_namespace,
+                                    escape(attribute_name), escape(value)))
+    for child in nodes:
+        describe(child, out)
+
+
+def find_roots(element, is_root, out):
+    if not isinstance(element.tag, str):
+        return
+    cls = element.get('class')
+    if cls is not None and is_root(cls):
+        out.append('R')
+        describe(element, out)
+        return
+    namespace, name = split_name(element.tag)
+    if name == 'template' and NAMESPACES.get(namespace, 0) == 0:
+        return
+    for child in element:
+        find_roots(child, is_root, out)
+
+
+def same_line(scanned, oracle):
+    # The scanner writes "?" for a tag Gumbo has no name for
+    if scanned == oracle:
+        return True
+    a, b = scanned.split(' '), oracle.split(' ')
+    return (a[0] in ('E', 'M') and len(a) == 5 and len(b) == 5 and
+            a[2] == '?' and a[:2] == b[:2] and a[3:] == b[3:])
+
+
+def check(directory, name):
+    with open(os.path.join(directory, name + '.roots'), encoding='utf-8',
+              errors='surrogateescape', newline='\n') as f:
+        lines = f.read().split('\n')
+    kind, scanned = lines[0], [line for line in lines[1:] if line]
+    with open(os.path.join(directory, name + '.html'), 'rb') as f:
+        page = f.read().decode('utf-8', 'replace')
+    oracle = []
+    find_roots(html5lib.parse(page, treebuilder='etree'),
+               is_betri_card if kind == 'betri' else is_skyn_list, oracle)
+    for i in range(max(len(scanned), len(oracle))):
+        a = scanned[i] if i < len(scanned) else '(nothing)'
+        b = oracle[i] if i < len(oracle) else '(nothing)'
+        if not same_line(a, b):
+            print('%s.html, line %d:\n  scanner:  %s\n  html5lib: %s'
+                  % (name, i + 1, a[:200], b[:200]))
+            return False
+    return True
+
+
+def main():
+    if len(sys.argv) != 2:
+        print('usage: scannerOracle.py DIR')
+        return 2
+    directory = sys.argv[1]
+    names = sorted(f[:-6] for f in os.listdir(directory)
+                   if f.endswith('.roots'))
+    differ = sum(not check(directory, name) for name in names)
+    print('%d pages, %d differ from html5lib' % (len(names), differ))
+    return 1 if differ else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())